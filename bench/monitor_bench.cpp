@@ -0,0 +1,222 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "cgroup_stats.h"
+#include "linux_parser.h"
+#include "process.h"
+#include "process_snapshot.h"
+#include "scan_pool.h"
+#include "system.h"
+#include "user_cache.h"
+
+/*
+Microbenchmarks of the LinuxParser functions and Process accessors
+Everything reads the checked-in fixture tree (bench/fixtures) instead of
+the live /proc, so the numbers only move when the code does. Every
+benchmark reports wall time and heap allocations per call.
+*/
+
+#define FIXTURE_PID 4242
+
+namespace {
+std::atomic<unsigned long> allocations{0};
+
+struct Settings {
+  std::string fixtures{MONITOR_FIXTURES};
+  std::string filter{};
+  double min_time{0.2};  // seconds per benchmark
+};
+
+// Keep the compiler from dropping a result that is never used
+template <typename T>
+void Keep(const T& value) {
+  asm volatile("" : : "r,m"(value) : "memory");
+}
+
+// Run function often enough to fill min_time; report the last round
+template <typename Function>
+void Measure(const Settings& settings, const char* name, Function function) {
+  if (std::string_view(name).find(settings.filter) == std::string_view::npos) {
+    return;
+  }
+  function();  // first call grows the reusable buffers
+
+  unsigned long iterations = 1;
+  while (true) {
+    const unsigned long allocations_before = allocations;
+    const auto start = std::chrono::steady_clock::now();
+    for (unsigned long i = 0; i < iterations; ++i) function();
+    const double elapsed = std::chrono::duration<double>(
+                               std::chrono::steady_clock::now() - start)
+                               .count();
+    const unsigned long allocated = allocations - allocations_before;
+    if (elapsed >= settings.min_time || iterations >= 1ul << 40) {
+      std::printf("%-40s %12lu %12.1f %10.2f\n", name, iterations,
+                  elapsed * 1e9 / iterations,
+                  static_cast<double>(allocated) / iterations);
+      return;
+    }
+    // Aim a little past min_time, but never more than 100 times as long
+    const double scale = elapsed > 0 ? settings.min_time * 1.2 / elapsed : 100;
+    iterations = static_cast<unsigned long>(
+        iterations * std::clamp(scale, 2.0, 100.0));
+  }
+}
+
+bool Parse(int argc, char* argv[], Settings& settings) {
+  for (int i = 1; i < argc; ++i) {
+    const std::string flag = argv[i];
+    if (i + 1 >= argc) return false;
+    if (flag == "--fixtures") {
+      settings.fixtures = argv[++i];
+    } else if (flag == "--filter") {
+      settings.filter = argv[++i];
+    } else if (flag == "--min-time") {
+      settings.min_time = std::atof(argv[++i]);
+      if (!(settings.min_time > 0)) return false;
+    } else {
+      return false;
+    }
+  }
+  return true;
+}
+
+void ParserBenchmarks(const Settings& settings) {
+  using namespace LinuxParser;
+  const int pid = FIXTURE_PID;
+
+  Measure(settings, "LinuxParser::OperatingSystem",
+          [] { Keep(OperatingSystem()); });
+  Measure(settings, "LinuxParser::Kernel", [] { Keep(Kernel()); });
+  Measure(settings, "LinuxParser::Pids", [] { Keep(Pids()); });
+  Measure(settings, "LinuxParser::MemoryUtilization",
+          [] { Keep(MemoryUtilization()); });
+  MemorySnapshot memory;
+  Measure(settings, "LinuxParser::Memory", [&memory] {
+    Memory(memory);
+    Keep(memory);
+  });
+  Measure(settings, "LinuxParser::UpTime", [] { Keep(UpTime()); });
+  Measure(settings, "LinuxParser::Stat", [] { Keep(Stat()); });
+  StatSample sample;
+  Measure(settings, "LinuxParser::Stat(reused)", [&sample] {
+    Stat(sample);
+    Keep(sample);
+  });
+  Measure(settings, "LinuxParser::CpuUtilization",
+          [] { Keep(CpuUtilization()); });
+  Measure(settings, "LinuxParser::Jiffies", [] { Keep(Jiffies()); });
+  Measure(settings, "LinuxParser::ActiveJiffies",
+          [] { Keep(ActiveJiffies()); });
+  Measure(settings, "LinuxParser::IdleJiffies", [] { Keep(IdleJiffies()); });
+  Measure(settings, "LinuxParser::TotalProcesses",
+          [] { Keep(TotalProcesses()); });
+  Measure(settings, "LinuxParser::RunningProcesses",
+          [] { Keep(RunningProcesses()); });
+  Measure(settings, "LinuxParser::ActiveJiffies(pid)",
+          [pid] { Keep(ActiveJiffies(pid)); });
+  Measure(settings, "LinuxParser::Command", [pid] { Keep(Command(pid)); });
+  std::string command;
+  Measure(settings, "LinuxParser::ReadCommand", [pid, &command] {
+    ReadCommand(pid, command);
+    Keep(command);
+  });
+  Measure(settings, "LinuxParser::Ram", [pid] { Keep(Ram(pid)); });
+  Measure(settings, "LinuxParser::Uid", [pid] { Keep(Uid(pid)); });
+  Measure(settings, "LinuxParser::User", [pid] { Keep(User(pid)); });
+  Measure(settings, "LinuxParser::UserName", [] { Keep(UserName(1000)); });
+  Measure(settings, "LinuxParser::UpTime(pid)", [pid] { Keep(UpTime(pid)); });
+  ProcessSnapshot snapshot;
+  const long uptime = UpTime();
+  Measure(settings, "LinuxParser::ReadProcess", [pid, uptime, &snapshot] {
+    Keep(ReadProcess(pid, uptime, snapshot));
+  });
+  Measure(settings, "LinuxParser::ReadProcess(smaps)",
+          [pid, uptime, &snapshot] {
+            Keep(ReadProcess(pid, uptime, snapshot, kSmapsFields));
+          });
+}
+
+void ProcessBenchmarks(const Settings& settings) {
+  ProcessSnapshot snapshot;
+  LinuxParser::ReadProcess(FIXTURE_PID, LinuxParser::UpTime(), snapshot);
+  snapshot.user = UserCache::Instance().Name(snapshot.uid);
+  ProcessSnapshot other = snapshot;
+  other.rss /= 2;
+  const Process process(snapshot);
+  const Process smaller(other);
+
+  Measure(settings, "Process::GetPid", [&process] { Keep(process.GetPid()); });
+  Measure(settings, "Process::GetUid", [&process] { Keep(process.GetUid()); });
+  Measure(settings, "Process::GetUser",
+          [&process] { Keep(process.GetUser()); });
+  Measure(settings, "Process::GetCommand",
+          [&process] { Keep(process.GetCommand()); });
+  Measure(settings, "Process::GetCpuUtilization",
+          [&process] { Keep(process.GetCpuUtilization()); });
+  Measure(settings, "Process::GetRam", [&process] { Keep(process.GetRam()); });
+  Measure(settings, "Process::GetVsz", [&process] { Keep(process.GetVsz()); });
+  Measure(settings, "Process::GetRss", [&process] { Keep(process.GetRss()); });
+  Measure(settings, "Process::GetUpTime",
+          [&process] { Keep(process.GetUpTime()); });
+  Measure(settings, "Process::operator<",
+          [&process, &smaller] { Keep(smaller < process); });
+}
+
+void SystemBenchmarks(const Settings& settings) {
+  System system;
+  Measure(settings, "System::Refresh", [&system] {
+    system.Refresh();
+    Keep(system.Current());
+  });
+
+  CgroupStats cgroups;
+  ScanPool pool;
+  std::vector<CgroupSnapshot> output;
+  Measure(settings, "CgroupStats::Refresh", [&] {
+    cgroups.Refresh(system.Current().processes, pool, output);
+    Keep(output);
+  });
+}
+}  // namespace
+
+// Count every allocation of the process; the benchmarks are serial
+void* operator new(std::size_t size) {
+  ++allocations;
+  if (void* memory = std::malloc(size == 0 ? 1 : size)) return memory;
+  throw std::bad_alloc();
+}
+void* operator new[](std::size_t size) { return operator new(size); }
+void operator delete(void* memory) noexcept { std::free(memory); }
+void operator delete[](void* memory) noexcept { std::free(memory); }
+void operator delete(void* memory, std::size_t) noexcept { std::free(memory); }
+void operator delete[](void* memory, std::size_t) noexcept {
+  std::free(memory);
+}
+
+int main(int argc, char* argv[]) {
+  Settings settings;
+  if (!Parse(argc, argv, settings)) {
+    std::fprintf(stderr,
+                 "usage: %s [--fixtures DIR] [--filter TEXT] [--min-time "
+                 "SEC]\n",
+                 argv[0]);
+    return 1;
+  }
+  LinuxParser::SetRoots(settings.fixtures + "/proc", settings.fixtures + "/etc",
+                        settings.fixtures + "/cgroup");
+  UserCache::Instance().Refresh();
+
+  std::printf("%-40s %12s %12s %10s\n", "benchmark", "iterations", "ns/op",
+              "allocs/op");
+  ParserBenchmarks(settings);
+  ProcessBenchmarks(settings);
+  SystemBenchmarks(settings);
+}
@@ -0,0 +1,247 @@
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "linux_parser.h"
+#include "synthetic_proc.h"
+#include "system.h"
+#include "user_cache.h"
+
+/*
+End-to-end tick latency of the sampling pipeline on synthetic trees
+For every process count a child process generates a tree, points
+LinuxParser at it and times Refresh plus what the display pulls per
+frame. It prints one JSON object per process count with p50/p99 tick
+latency, syscalls per tick and peak RSS, so runs can be compared or
+plotted. Syscalls are counted with the raw_syscalls tracepoint, which
+needs tracefs and perf permissions; without them the count is null.
+*/
+
+#define DISPLAYED_PROCESSES 10
+
+using std::string;
+using std::vector;
+
+namespace {
+struct Settings {
+  vector<long> processes{1000, 10000, 100000};
+  SyntheticProc::Shape shape{};
+  int scan_threads{1};
+  int ticks{20};
+  string directory{"/dev/shm"};
+  bool keep{false};
+};
+
+// Counts syscalls entered by this process and threads started later
+class SyscallCounter {
+ public:
+  SyscallCounter() {
+    long id = -1;
+    for (const char* path :
+         {"/sys/kernel/tracing/events/raw_syscalls/sys_enter/id",
+          "/sys/kernel/debug/tracing/events/raw_syscalls/sys_enter/id"}) {
+      std::ifstream stream(path);
+      if (stream >> id) break;
+    }
+    if (id < 0) return;
+    perf_event_attr attributes{};
+    attributes.type = PERF_TYPE_TRACEPOINT;
+    attributes.size = sizeof(attributes);
+    attributes.config = id;
+    attributes.disabled = 1;
+    attributes.inherit = 1;  // the scan pool's threads
+    fd = static_cast<int>(
+        syscall(SYS_perf_event_open, &attributes, 0, -1, -1, 0));
+  }
+  ~SyscallCounter() {
+    if (fd >= 0) close(fd);
+  }
+  bool Available() const { return fd >= 0; }
+  void Start() {
+    if (fd < 0) return;
+    ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+    ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+  }
+  uint64_t Stop() {
+    uint64_t count = 0;
+    if (fd < 0) return count;
+    ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+    if (read(fd, &count, sizeof(count)) != sizeof(count)) count = 0;
+    return count;
+  }
+
+ private:
+  int fd{-1};
+};
+
+double Percentile(const vector<double>& sorted, double fraction) {
+  const size_t rank = static_cast<size_t>(std::ceil(fraction * sorted.size()));
+  return sorted[std::max<size_t>(rank, 1) - 1];
+}
+
+// One process count, in a child so peak RSS is its own
+void Run(const Settings& settings, long processes) {
+  SyntheticProc::Shape shape = settings.shape;
+  shape.processes = static_cast<int>(processes);
+  const string root = settings.directory + "/monitor-scale-" +
+                      std::to_string(getpid());
+
+  const auto generate_start = std::chrono::steady_clock::now();
+  SyntheticProc::Generate(root, shape);
+  const double generate_ms = std::chrono::duration<double, std::milli>(
+                                 std::chrono::steady_clock::now() -
+                                 generate_start)
+                                 .count();
+  LinuxParser::SetRoots(root + "/proc", root + "/etc");
+
+  // Created first so the pool's threads inherit the counter
+  SyscallCounter counter;
+  System system(settings.scan_threads);
+  vector<double> latencies;
+  uint64_t syscalls = 0;
+  // The first tick fills caches and buffers; it is timed separately
+  for (int tick = 0; tick <= settings.ticks; ++tick) {
+    counter.Start();
+    const auto start = std::chrono::steady_clock::now();
+    system.Refresh();
+    // What a frame of the display reads
+    volatile float panel = system.MemoryUtilization() +
+                           system.Cpu().Utilization() + system.UpTime() +
+                           system.TotalProcesses() + system.RunningProcesses();
+    (void)panel;
+    volatile size_t shown = system.Processes(DISPLAYED_PROCESSES).size();
+    (void)shown;
+    const double elapsed = std::chrono::duration<double, std::milli>(
+                               std::chrono::steady_clock::now() - start)
+                               .count();
+    const uint64_t count = counter.Stop();
+    if (tick == 0) continue;
+    latencies.push_back(elapsed);
+    syscalls += count;
+  }
+  if (!settings.keep) SyntheticProc::Remove(root);
+
+  std::sort(latencies.begin(), latencies.end());
+  const double p50 = Percentile(latencies, 0.5);
+  rusage usage{};
+  getrusage(RUSAGE_SELF, &usage);
+
+  std::printf(
+      "{\"processes\":%ld,\"threads_per_process\":%d,\"cmdline_length\":%d,"
+      "\"users\":%d,\"scan_threads\":%d,\"ticks\":%d,\"generate_ms\":%.1f,"
+      "\"scanned\":%zu,\"p50_ms\":%.3f,\"p99_ms\":%.3f,\"max_ms\":%.3f,"
+      "\"p50_ns_per_process\":%.1f,",
+      processes, shape.threads, shape.cmdline_length, shape.users,
+      settings.scan_threads, settings.ticks, generate_ms,
+      system.Current().processes.size(), p50, Percentile(latencies, 0.99),
+      latencies.back(), p50 * 1e6 / processes);
+  if (counter.Available()) {
+    std::printf("\"syscalls_per_tick\":%.1f,",
+                static_cast<double>(syscalls) / settings.ticks);
+  } else {
+    std::printf("\"syscalls_per_tick\":null,");
+  }
+  std::printf("\"peak_rss_kb\":%ld}\n", usage.ru_maxrss);
+}
+
+vector<long> List(const string& text) {
+  vector<long> values;
+  size_t start = 0;
+  while (start <= text.size()) {
+    size_t end = text.find(',', start);
+    if (end == string::npos) end = text.size();
+    values.push_back(std::stol(text.substr(start, end - start)));
+    start = end + 1;
+  }
+  return values;
+}
+
+void Parse(int argc, char* argv[], Settings& settings) {
+  for (int i = 1; i < argc; ++i) {
+    const string flag = argv[i];
+    if (flag == "--keep") {
+      settings.keep = true;
+      continue;
+    }
+    if (i + 1 >= argc) throw std::invalid_argument("missing value");
+    const string value = argv[++i];
+    if (flag == "--processes") {
+      settings.processes = List(value);
+    } else if (flag == "--threads-per-process") {
+      settings.shape.threads = std::stoi(value);
+    } else if (flag == "--cmdline-length") {
+      settings.shape.cmdline_length = std::stoi(value);
+    } else if (flag == "--users") {
+      settings.shape.users = std::stoi(value);
+    } else if (flag == "--cores") {
+      settings.shape.cores = std::stoi(value);
+    } else if (flag == "--scan-threads") {
+      settings.scan_threads = std::stoi(value);
+    } else if (flag == "--ticks") {
+      settings.ticks = std::stoi(value);
+    } else if (flag == "--directory") {
+      settings.directory = value;
+    } else {
+      throw std::invalid_argument(flag);
+    }
+  }
+  for (long count : settings.processes) {
+    if (count < 1) throw std::invalid_argument("--processes");
+  }
+  if (settings.ticks < 1 || settings.shape.threads < 1 ||
+      settings.scan_threads < 1) {
+    throw std::invalid_argument("value below 1");
+  }
+}
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  Settings settings;
+  try {
+    Parse(argc, argv, settings);
+  } catch (const std::exception& error) {
+    std::fprintf(
+        stderr,
+        "%s: invalid arguments (%s)\n"
+        "usage: %s [--processes N,N,...] [--threads-per-process N]\n"
+        "       [--cmdline-length BYTES] [--users N] [--cores N]\n"
+        "       [--scan-threads N] [--ticks N] [--directory DIR] [--keep]\n",
+        argv[0], error.what(), argv[0]);
+    return 1;
+  }
+
+  int status = 0;
+  for (long processes : settings.processes) {
+    std::fflush(stdout);
+    const pid_t child = fork();
+    if (child < 0) return 1;
+    if (child == 0) {
+      try {
+        Run(settings, processes);
+      } catch (const std::exception& error) {
+        std::fprintf(stderr, "%s\n", error.what());
+        std::fflush(stdout);
+        _exit(1);
+      }
+      std::fflush(stdout);
+      _exit(0);
+    }
+    int child_status = 0;
+    waitpid(child, &child_status, 0);
+    if (!WIFEXITED(child_status) || WEXITSTATUS(child_status) != 0) status = 1;
+  }
+  return status;
+}
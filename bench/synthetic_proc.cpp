@@ -0,0 +1,164 @@
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+
+#include "synthetic_proc.h"
+
+#define PAGE_KILOBYTES 4
+#define FIRST_UID 1000
+
+using std::string;
+
+namespace {
+std::runtime_error Failure(const string& what, const string& path) {
+  return std::runtime_error(what + " " + path + ": " + std::strerror(errno));
+}
+
+void Directory(const string& path) {
+  if (mkdir(path.c_str(), 0755) != 0 && errno != EEXIST) {
+    throw Failure("cannot create", path);
+  }
+}
+
+void File(const string& path, const char* data, size_t size) {
+  int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (fd < 0) throw Failure("cannot create", path);
+  const bool written = write(fd, data, size) == static_cast<ssize_t>(size);
+  close(fd);
+  if (!written) throw Failure("cannot write", path);
+}
+
+void File(const string& path, const string& content) {
+  File(path, content.data(), content.size());
+}
+
+string Stat(int pid, const char* comm, char state, long utime, long stime,
+            long starttime, long vsz_pages, long rss_pages, int threads) {
+  char line[512];
+  int length = std::snprintf(
+      line, sizeof(line),
+      "%d (%s) %c 1 %d %d 0 -1 4194560 1204 0 0 0 %ld %ld 0 0 20 0 %d 0 "
+      "%ld %ld %ld 18446744073709551615 1 1 0 0 0 0 0 0 0 0 0 0 17 0 0 0 0 "
+      "0 0 0 0 0 0 0 0 0 0\n",
+      pid, comm, state, pid, pid, utime, stime, threads, starttime,
+      vsz_pages * PAGE_KILOBYTES * 1024, rss_pages);
+  return string(line, length);
+}
+
+void Process(const string& proc, int pid, int first_tid,
+             const SyntheticProc::Shape& shape) {
+  const string directory = proc + std::to_string(pid);
+  Directory(directory);
+
+  // Deterministic but varied, so sorting has work to do
+  const unsigned long mix = static_cast<unsigned long>(pid) * 2654435761u;
+  const long utime = mix % 100000;
+  const long stime = (mix >> 8) % 20000;
+  const long starttime = 100 + pid;
+  const long vsz_pages = 1024 + (mix >> 4) % 262144;
+  const long rss_pages = vsz_pages / (2 + mix % 8);
+  const int uid = shape.users > 0 ? FIRST_UID + pid % shape.users : 0;
+  const char state = mix % 50 == 0 ? 'R' : 'S';
+  // The kernel keeps 15 characters of the name
+  char comm[32];
+  std::snprintf(comm, sizeof(comm), "worker-%d", pid);
+  comm[15] = '\0';
+
+  File(directory + "/stat", Stat(pid, comm, state, utime, stime, starttime,
+                                 vsz_pages, rss_pages, shape.threads));
+  File(directory + "/statm",
+       std::to_string(vsz_pages) + " " + std::to_string(rss_pages) + " " +
+           std::to_string(rss_pages / 4) + " 100 0 " +
+           std::to_string(rss_pages / 2) + " 0\n");
+  File(directory + "/status",
+       string("Name:\t") + comm + "\nUmask:\t0022\nState:\t" + state +
+           " (sleeping)\nTgid:\t" + std::to_string(pid) + "\nPid:\t" +
+           std::to_string(pid) + "\nPPid:\t1\nUid:\t" + std::to_string(uid) +
+           "\t" + std::to_string(uid) + "\t" + std::to_string(uid) + "\t" +
+           std::to_string(uid) + "\nVmSize:\t" +
+           std::to_string(vsz_pages * PAGE_KILOBYTES) + " kB\nVmRSS:\t" +
+           std::to_string(rss_pages * PAGE_KILOBYTES) + " kB\nThreads:\t" +
+           std::to_string(shape.threads) + "\n");
+
+  // "/usr/bin/worker --id <pid>" padded with arguments to the length
+  string cmdline = "/usr/bin/worker";
+  cmdline.push_back('\0');
+  cmdline += "--id";
+  cmdline.push_back('\0');
+  cmdline += std::to_string(pid);
+  while (static_cast<int>(cmdline.size()) + 1 < shape.cmdline_length) {
+    cmdline.push_back('\0');
+    cmdline += "--opt";
+  }
+  cmdline.resize(std::max(shape.cmdline_length - 1, 0));
+  cmdline.push_back('\0');
+  File(directory + "/cmdline", cmdline);
+
+  if (shape.threads > 1) {
+    Directory(directory + "/task");
+    for (int i = 0; i < shape.threads; ++i) {
+      const int tid = i == 0 ? pid : first_tid + i - 1;
+      const string task = directory + "/task/" + std::to_string(tid);
+      Directory(task);
+      File(task + "/stat", Stat(tid, comm, 'S', utime / shape.threads,
+                                stime / shape.threads, starttime, vsz_pages,
+                                rss_pages, shape.threads));
+    }
+  }
+}
+}  // namespace
+
+void SyntheticProc::Generate(const string& root, const Shape& shape) {
+  const string proc = root + "/proc/";
+  const string etc = root + "/etc/";
+  Directory(root);
+  Directory(proc);
+  Directory(etc);
+
+  string stat = "cpu  ";
+  for (int i = 0; i <= shape.cores; ++i) {
+    const long scale = i == 0 ? shape.cores : 1;
+    if (i > 0) stat += "cpu" + std::to_string(i - 1) + " ";
+    stat += std::to_string(500000 * scale) + " 0 " +
+            std::to_string(200000 * scale) + " " +
+            std::to_string(9000000 * scale) + " 1000 0 500 0 0 0\n";
+  }
+  stat += "intr 1000000\nctxt 2000000\nbtime 1760000000\nprocesses " +
+          std::to_string(shape.processes * 3) + "\nprocs_running 2\n" +
+          "procs_blocked 0\n";
+  File(proc + "stat", stat);
+  File(proc + "meminfo",
+       "MemTotal:       65536000 kB\nMemFree:        32768000 kB\n"
+       "MemAvailable:   49152000 kB\nBuffers:          512000 kB\n"
+       "Cached:         12000000 kB\n");
+  File(proc + "uptime", "1000000.00 3000000.00\n");
+  File(proc + "version", "Linux version 6.8.0-synthetic (synthetic) #1 SMP\n");
+
+  string passwd = "root:x:0:0:root:/root:/bin/bash\n";
+  for (int i = 0; i < shape.users; ++i) {
+    const string name = "user" + std::to_string(i);
+    passwd += name + ":x:" + std::to_string(FIRST_UID + i) + ":" +
+              std::to_string(FIRST_UID + i) + "::/home/" + name +
+              ":/bin/bash\n";
+  }
+  File(etc + "passwd", passwd);
+  File(etc + "os-release", "PRETTY_NAME=\"Synthetic Linux\"\n");
+
+  // Thread IDs come after every process ID, as if started later
+  const int first_tid = shape.processes + 1;
+  for (int pid = 1; pid <= shape.processes; ++pid) {
+    Process(proc, pid, first_tid + (pid - 1) * (shape.threads - 1), shape);
+  }
+}
+
+void SyntheticProc::Remove(const string& root) {
+  std::error_code error;
+  std::filesystem::remove_all(root, error);
+}
@@ -0,0 +1,27 @@
+#ifndef SYNTHETIC_PROC_H
+#define SYNTHETIC_PROC_H
+
+#include <string>
+
+/*
+Builds /proc- and /etc-shaped trees of any size for scaling runs
+The files carry the fields LinuxParser reads, with values derived from
+the PID so every run sees the same tree. Put the root on tmpfs (e.g.
+/dev/shm) so the numbers measure the monitor rather than a disk.
+*/
+namespace SyntheticProc {
+struct Shape {
+  int processes{1000};
+  int threads{1};          // per process, listed under <pid>/task
+  int cmdline_length{64};  // bytes of /proc/<pid>/cmdline
+  int users{100};          // /etc/passwd entries besides root
+  int cores{4};            // cpuN lines in /proc/stat
+};
+
+// Create root/proc and root/etc; throws std::runtime_error on failure
+void Generate(const std::string& root, const Shape& shape);
+// Delete a tree made by Generate
+void Remove(const std::string& root);
+};  // namespace SyntheticProc
+
+#endif
@@ -0,0 +1,42 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <cstddef>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+/*
+Bump allocator for text that lives exactly as long as one snapshot
+Copies go into blocks that never move, so the views stay valid until
+Reset, even when the arena itself is moved. Reset rewinds to the first
+block and keeps them all, so after warm-up a tick allocates nothing and
+the footprint stays at the largest tick seen.
+*/
+class Arena {
+ public:
+  Arena() = default;
+  Arena(Arena&&) = default;
+  Arena& operator=(Arena&&) = default;
+  Arena(const Arena&) = delete;
+  Arena& operator=(const Arena&) = delete;
+
+  std::string_view Copy(std::string_view text);
+  // Drop every copy at once; views handed out before are invalid
+  void Reset();
+  std::size_t Capacity() const;  // bytes held
+  std::size_t Used() const;      // bytes handed out since Reset
+
+ private:
+  struct Block {
+    std::unique_ptr<char[]> data;
+    std::size_t size;
+  };
+
+  std::vector<Block> blocks = {};
+  std::size_t current = 0;  // block being filled
+  std::size_t offset = 0;   // into the current block
+  std::size_t used = 0;
+};
+
+#endif
@@ -0,0 +1,23 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include "options.h"
+#include "output_buffer.h"
+#include "sampler.h"
+#include "system_snapshot.h"
+
+/*
+Headless mode: sample with the same Sampler as the UI, paced on the
+calling thread, and stream every tick to stdout without curses
+*/
+namespace Batch {
+// Returns the process exit status
+int Run(Sampler& sampler, const Options& options);
+// One row per process, preceded by a header row when header is set
+void WriteCsv(const SystemSnapshot& snapshot, bool header,
+              OutputBuffer& output);
+// One object per tick, holding its processes
+void WriteJson(const SystemSnapshot& snapshot, OutputBuffer& output);
+};  // namespace Batch
+
+#endif
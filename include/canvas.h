@@ -0,0 +1,37 @@
+#ifndef CANVAS_H
+#define CANVAS_H
+
+#include <curses.h>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/*
+Shadow copy of the inside of a boxed curses window
+Print compares every cell with what the previous frame left there and
+only hands the cells that changed to curses, so an idle screen costs
+neither CPU nor terminal bandwidth
+*/
+class Canvas {
+ public:
+  explicit Canvas(WINDOW* window);
+  // Write text at row/column, padded with blanks to width cells
+  // (0: the text's own length) and clipped at the border
+  void Print(int row, int column, std::string_view text, int width = 0,
+             attr_t attributes = A_NORMAL);
+  // Show text in the top border; only redrawn when it changes
+  void Title(std::string_view text);
+  // Adopt a new window size, keeping every cell that is still visible
+  void Resize(int rows, int columns);
+  WINDOW* Window() const;
+  int Columns() const;
+
+ private:
+  WINDOW* window;
+  int rows;
+  int columns;
+  std::vector<chtype> cells;
+  std::string title;
+};
+
+#endif
@@ -0,0 +1,23 @@
+#ifndef CGROUP_SNAPSHOT_H
+#define CGROUP_SNAPSHOT_H
+
+#include <string>
+
+/*
+Plain record of what one cgroup used during a tick, from its cpu.stat,
+memory.current, memory.stat and io.stat. Rates cover the time since the
+cgroup was last read and are 0 the first time it is seen.
+*/
+struct CgroupSnapshot {
+  std::string path{};       // below the cgroup root, "/" for the root
+  int processes{0};         // sampled processes in it
+  float cpu{0};             // share of one CPU, like a process's
+  float throttled{0};       // share of the interval spent throttled
+  long memory{0};           // kB, memory.current
+  long anon{0};             // kB, memory.stat
+  long file{0};             // kB, page cache
+  double read_rate{0};      // bytes per second, all devices
+  double write_rate{0};
+};
+
+#endif
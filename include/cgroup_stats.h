@@ -0,0 +1,75 @@
+#ifndef CGROUP_STATS_H
+#define CGROUP_STATS_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "cgroup_snapshot.h"
+#include "process_snapshot.h"
+#include "scan_pool.h"
+
+/*
+Resource use per cgroup, read from the cgroup v2 tree
+Each tick reads the counters of every cgroup that holds at least one
+sampled process and turns them into rates over the time since its last
+read. Which cgroup a process is in comes from /proc/<pid>/cgroup, read
+once per process: a process that moves keeps its first cgroup. Without
+a v2 hierarchy at LinuxParser::CgroupDirectory() nothing is read.
+*/
+class CgroupStats {
+ public:
+  CgroupStats();
+  bool Available() const;
+  // processes are in PID order; cgroups gets one entry per cgroup in use
+  void Refresh(const std::vector<ProcessSnapshot>& processes, ScanPool& pool,
+               std::vector<CgroupSnapshot>& cgroups);
+
+ private:
+  static constexpr uint32_t kNone = UINT32_MAX;
+
+  // A process and the cgroup it was found in
+  struct Member {
+    int pid;
+    long starttime;
+    uint32_t cgroup;
+  };
+
+  // Raw counters, to take the next tick's differences from
+  struct Counters {
+    uint64_t usage_usec{0};
+    uint64_t throttled_usec{0};
+    uint64_t read_bytes{0};
+    uint64_t write_bytes{0};
+  };
+
+  struct Cgroup {
+    std::string path{};
+    std::string directory{};  // full path with a trailing '/'
+    unsigned long tick{0};    // last tick it held a process
+    int processes{0};
+    bool read{false};         // counters hold an earlier read
+    Counters counters{};
+    std::chrono::steady_clock::time_point time{};
+    CgroupSnapshot snapshot{};
+  };
+
+  uint32_t Intern(const std::string& path);
+  void Read(Cgroup& cgroup, std::chrono::steady_clock::time_point now);
+
+  const bool available;
+  unsigned long tick = 0;
+  std::vector<Member> members = {};  // PID order
+  std::vector<Member> spare = {};
+  std::vector<std::size_t> unknown = {};  // indexes into members
+  std::vector<std::string> paths = {};    // read for unknown
+  std::vector<Cgroup> cgroups = {};
+  std::vector<uint32_t> unused = {};
+  std::unordered_map<std::string, uint32_t> ids = {};
+  std::vector<uint32_t> used = {};  // cgroups with processes this tick
+};
+
+#endif
@@ -0,0 +1,44 @@
+#ifndef CPU_ACCOUNTING_H
+#define CPU_ACCOUNTING_H
+
+#include <chrono>
+#include <list>
+#include <unordered_map>
+
+#include "process_snapshot.h"
+
+/*
+Per-PID CPU time remembered between ticks
+Entries are keyed on (pid, starttime) so a recycled PID starts over.
+They are kept in most-recently-seen order, which lets Sweep drop the
+processes that exited without looking at the ones still alive.
+*/
+class CpuAccounting {
+ public:
+  // Start a new tick at the given time
+  void Begin(std::chrono::steady_clock::time_point now);
+  // Replace the lifetime average in snapshot.cpu_utilization with the
+  // share of one CPU used since the process was last updated, when known
+  void Update(ProcessSnapshot& snapshot);
+  // Count a process whose times were not read this tick as seen
+  void Keep(const ProcessSnapshot& snapshot);
+  // Forget every process that was not updated during this tick
+  void Sweep();
+  std::size_t Size() const;
+
+ private:
+  struct Entry {
+    int pid;
+    long starttime;
+    long jiffies;
+    unsigned long tick;
+    std::chrono::steady_clock::time_point time;
+  };
+
+  std::list<Entry> entries = {};
+  std::unordered_map<int, std::list<Entry>::iterator> index = {};
+  std::chrono::steady_clock::time_point last = {};
+  unsigned long tick = 0;
+};
+
+#endif
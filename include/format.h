@@ -1,10 +1,14 @@
 #ifndef FORMAT_H
 #define FORMAT_H
 
+#include <cstddef>
 #include <string>
+#include <string_view>
 
 namespace Format {
 std::string ElapsedTime(long times);
+// Same as above, written into a caller owned buffer
+std::string_view ElapsedTime(long times, char* buffer, std::size_t size);
 };
 
-#endif
\ No newline at end of file
+#endif
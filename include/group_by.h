@@ -0,0 +1,48 @@
+#ifndef GROUP_BY_H
+#define GROUP_BY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "process_table.h"
+#include "top_processes.h"
+
+// What the process list is totalled by; kNone lists single processes
+enum class GroupKey { kNone, kUser, kCommand, kParent };
+
+// The next grouping in the order the display cycles through them
+GroupKey NextGroupKey(GroupKey key);
+
+struct Group {
+  uint32_t key;    // index into users or commands, or the parent's row;
+                   // the table's size for processes without a parent
+  uint32_t count;  // processes
+  float cpu;       // sum of shares of one CPU
+  int64_t rss;     // kB
+  int64_t vsz;     // kB
+};
+
+/*
+Totals of CPU and memory per user, command line or parent process
+Every total is one pass over the key column and one value column of the
+table into an array indexed by key, so no pass chases pointers or hashes.
+Only the n largest groups are sorted, like TopProcesses does.
+*/
+class GroupBy {
+ public:
+  // The n first groups of table under key in the given order; kTime and
+  // kPid order by process count
+  const std::vector<Group>& Select(const ProcessTable& table, GroupKey key,
+                                   SortKey sorting, std::size_t n);
+
+ private:
+  std::vector<uint32_t> keys = {};
+  std::vector<uint32_t> counts = {};
+  std::vector<float> cpu = {};
+  std::vector<int64_t> rss = {};
+  std::vector<int64_t> vsz = {};
+  std::vector<Group> groups = {};
+};
+
+#endif
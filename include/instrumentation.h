@@ -0,0 +1,83 @@
+#ifndef INSTRUMENTATION_H
+#define INSTRUMENTATION_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+
+/*
+Timings and counters of the monitor's own work
+Each phase keeps a fixed-size latency histogram, so recording never
+allocates. Until Enable is called every hook is a single relaxed load
+of a flag. Recording is thread-safe; the scan threads count too.
+*/
+namespace Instrumentation {
+enum class Phase {
+  kRefresh,
+  kPidScan,
+  kParse,
+  kAccounting,  // CPU shares, command lines and gaps of exited processes
+  kUsers,       // user names copied into the snapshot
+  kCgroups,
+  kSort,
+  kRender,
+  kCount
+};
+enum class Counter {
+  kFilesOpened,
+  kBytesRead,
+  kAllocations,
+  kDeferred,  // processes the refresh schedule skipped
+  kCount
+};
+
+struct Summary {
+  uint64_t count{0};
+  double total_ms{0};
+  double p50_us{0};  // histogram resolution: a quarter of a power of two
+  double p99_us{0};
+  double max_us{0};
+};
+
+extern std::atomic<bool> enabled;
+
+inline bool Enabled() { return enabled.load(std::memory_order_relaxed); }
+void Enable();
+// Back to the fast path; what was recorded so far is kept
+void Disable();
+
+void Record(Phase phase, std::chrono::nanoseconds elapsed);
+void AddSlow(Counter counter, uint64_t amount);
+inline void Add(Counter counter, uint64_t amount = 1) {
+  if (Enabled()) AddSlow(counter, amount);
+}
+
+Summary Summarize(Phase phase);
+uint64_t Total(Counter counter);
+const char* Name(Phase phase);
+const char* Name(Counter counter);
+// Table of every phase and counter, e.g. to stderr on exit
+void Dump(std::FILE* stream);
+
+// Records the time from construction to destruction under phase
+class ScopedTimer {
+ public:
+  explicit ScopedTimer(Phase input_phase) : phase(input_phase) {
+    if (Enabled()) start = std::chrono::steady_clock::now();
+  }
+  ~ScopedTimer() {
+    if (start != std::chrono::steady_clock::time_point()) {
+      Record(phase, std::chrono::steady_clock::now() - start);
+    }
+  }
+  ScopedTimer(const ScopedTimer&) = delete;
+  ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+ private:
+  Phase phase;
+  std::chrono::steady_clock::time_point start{};
+};
+};  // namespace Instrumentation
+
+#endif
@@ -1,34 +1,64 @@
 #ifndef SYSTEM_PARSER_H
 #define SYSTEM_PARSER_H
 
+#include <array>
+#include <cstddef>
+#include <cstdint>
 #include <fstream>
 #include <regex>
 #include <string>
+#include <vector>
+
+#include "memory_snapshot.h"
+#include "process_snapshot.h"
 
 namespace LinuxParser {
 // Paths
 const std::string kProcDirectory{"/proc/"};
 const std::string kCmdlineFilename{"/cmdline"};
+const std::string kCgroupFilename{"/cgroup"};
 const std::string kCpuinfoFilename{"/cpuinfo"};
 const std::string kStatusFilename{"/status"};
 const std::string kStatFilename{"/stat"};
+const std::string kStatmFilename{"/statm"};
+const std::string kSmapsRollupFilename{"/smaps_rollup"};
 const std::string kUptimeFilename{"/uptime"};
 const std::string kMeminfoFilename{"/meminfo"};
 const std::string kVersionFilename{"/version"};
 const std::string kOSPath{"/etc/os-release"};
 const std::string kPasswordPath{"/etc/passwd"};
+const std::string kCgroupDirectory{"/sys/fs/cgroup/"};
+const std::string kOSReleaseFilename{"os-release"};
+const std::string kPasswordFilename{"passwd"};
 const std::string TOTAL_MEMORY {"MemTotal"};
 const std::string FREE_MEMORY {"MemFree"};
-const std::string VMSIZE {"VmSize"};
+const std::string AVAILABLE_MEMORY {"MemAvailable"};
+const std::string VMRSS {"VmRSS"};
 const std::string UID {"Uid"};
 const std::string PROCESS_RUNNING {"procs_running"};
-const std::string PROCESS {"process"};
+const std::string PROCESS {"processes"};
+const std::string CPU {"cpu"};
+const std::string CONTEXT_SWITCHES {"ctxt"};
+const std::string INTERRUPTS {"intr"};
 const std::string EMPTY{""};
 
+// Roots every path is read from, /proc/, /etc/ and /sys/fs/cgroup/ unless
+// changed, e.g. to a fixture tree; set them before any sampling starts
+void SetRoots(const std::string& proc, const std::string& etc,
+              const std::string& cgroup = kCgroupDirectory);
+const std::string& ProcDirectory();
+const std::string& CgroupDirectory();
+const std::string& OSPath();
+const std::string& PasswordPath();
+
 // System
+// Share of memory in use, 1 - MemAvailable / MemTotal
 float MemoryUtilization();
+float MemoryUtilization(const MemorySnapshot& memory);
+// Same breakdown free(1) shows; false when /proc/meminfo is unreadable
+bool Memory(MemorySnapshot& memory);
 long UpTime();
-std::vector<int> Pids();
+std::vector<int> Pids();  // ascending
 int TotalProcesses();
 int RunningProcesses();
 std::string OperatingSystem();
@@ -47,6 +77,35 @@ enum CPUStates {
   kGuest_,
   kGuestNice_
 };
+// Counters of one "cpu" line of /proc/stat, indexed by CPUStates
+struct CpuTimes {
+  std::array<unsigned long long, kGuestNice_ + 1> jiffies{};
+  unsigned long long Active() const;
+  unsigned long long Idle() const;
+  unsigned long long Total() const;
+};
+
+// Per-core counters of the "cpuN" lines, one array per counter so a
+// pass over all cores reads contiguous memory
+struct CoreTimes {
+  std::vector<uint64_t> busy{};   // CpuTimes::Active
+  std::vector<uint64_t> total{};  // CpuTimes::Total
+  std::size_t Size() const { return total.size(); }
+};
+
+// Everything the monitor needs from a single read of /proc/stat
+struct StatSample {
+  CpuTimes cpu{};
+  CoreTimes cores{};
+  unsigned long long context_switches{0};
+  unsigned long long interrupts{0};
+  long processes{0};
+  int procs_running{0};
+};
+
+StatSample Stat();
+// Same, reusing sample's storage; returns false when /proc/stat is unreadable
+bool Stat(StatSample& sample);
 std::vector<std::string> CpuUtilization();
 long Jiffies();
 long ActiveJiffies();
@@ -55,10 +114,34 @@ long IdleJiffies();
 
 // Processes
 std::string Command(int pid);
+// Same, into command's storage; false when the process is gone
+bool ReadCommand(int pid, std::string& command);
+// The process's cgroup v2 path, e.g. "/system.slice/nginx.service", from
+// the "0::" line of /proc/<pid>/cgroup; false when there is none
+bool ReadCgroup(int pid, std::string& path);
+// Resident set in kB, from statm
 std::string Ram(int pid);
 std::string Uid(int pid);
 std::string User(int pid);
+std::string UserName(int uid);
 long int UpTime(int pid);
+// Classes of per-process fields, each read from one file of /proc/<pid>
+enum ProcessFields : unsigned {
+  kStatFields = 1u << 0,     // stat: name, state, CPU times, start time
+  kMemoryFields = 1u << 1,   // statm: vsz, rss, shared
+  kStatusFields = 1u << 2,   // status: uid
+  kCommandFields = 1u << 3,  // cmdline
+  kAllFields = kStatFields | kMemoryFields | kStatusFields | kCommandFields,
+  // smaps_rollup: pss, uss. Walking every mapping costs far more than the
+  // other files together, so it is not part of kAllFields and only read
+  // when asked for by name
+  kSmapsFields = 1u << 4
+};
+// Fill the given fields of snapshot from /proc/<pid> and leave the others
+// alone. The command views storage of the calling thread, valid until
+// its next ReadProcess. Returns false when the process is gone.
+bool ReadProcess(int pid, long uptime, ProcessSnapshot& snapshot,
+                 unsigned fields = kAllFields);
 };  // namespace LinuxParser
 
 #endif
\ No newline at end of file
@@ -0,0 +1,22 @@
+#ifndef MEMORY_SNAPSHOT_H
+#define MEMORY_SNAPSHOT_H
+
+/*
+Plain record of the system's memory, from one read of /proc/meminfo.
+Everything is in kB. Available is the kernel's own estimate of what can
+be handed out without swapping, so page cache does not count as used.
+*/
+struct MemorySnapshot {
+  long total{0};
+  long available{0};   // MemAvailable, or free + buffers + cached before 3.14
+  long free{0};
+  long buffers{0};
+  long cached{0};      // page cache and reclaimable slab, as free(1) shows
+  long shared{0};      // tmpfs and shared anonymous memory, part of cached
+  long swap_total{0};
+  long swap_free{0};
+  long huge_total{0};  // reserved for huge pages, whether in use or not
+  long huge_free{0};
+};
+
+#endif
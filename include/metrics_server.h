@@ -0,0 +1,82 @@
+#ifndef METRICS_SERVER_H
+#define METRICS_SERVER_H
+
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "metrics_text.h"
+#include "system_snapshot.h"
+
+/*
+Serves GET /metrics over HTTP for Prometheus
+Publish renders the whole response, headers included, once per tick on
+the sampling thread. The server thread hands every scrape a reference
+to the newest response and only writes it out, so scrapes never cost a
+/proc scan or a serialization, however many scrapers there are. Each
+buffer counts the scrapes still writing it, under the mutex, and is
+only rendered into again once that count is back to 0. One request per
+connection, answered with Connection: close.
+*/
+class MetricsServer {
+ public:
+  // address is "host:port", ":port" or "[v6 address]:port"; throws
+  // std::runtime_error when it cannot be listened on
+  MetricsServer(const std::string& address, std::size_t top);
+  ~MetricsServer();
+  MetricsServer(const MetricsServer&) = delete;
+  MetricsServer& operator=(const MetricsServer&) = delete;
+
+  // Start and stop answering on the server thread
+  void Start();
+  void Stop();
+  // Render the response scrapes get from now on
+  void Publish(const SystemSnapshot& snapshot);
+
+ private:
+  struct Buffer {
+    std::string response{};
+    int readers{0};  // guarded by mutex
+  };
+
+  struct Connection {
+    int descriptor;
+    std::string request;            // bytes read until the blank line
+    const std::string* response;    // being written once set
+    Buffer* buffer;                 // holding response, if rendered
+    std::size_t written;
+    std::chrono::steady_clock::time_point since;
+  };
+
+  void Run();
+  void Accept();
+  // Read or write what the socket takes; false once it is done with
+  bool Serve(Connection& connection);
+  // Point connection at the response to request
+  void Answer(Connection& connection);
+  // Close connection and let go of its buffer
+  void Close(Connection& connection);
+
+  int listener{-1};
+  int wake{-1};  // eventfd that stops Run
+  std::thread thread{};
+  std::vector<Connection> connections{};  // server thread only
+
+  // Sampling thread only
+  MetricsText text;
+  std::string body{};
+  // Two take turns unless scrapes outlast a tick
+  std::vector<std::unique_ptr<Buffer>> buffers{};
+
+  std::mutex mutex{};
+  Buffer* current{nullptr};  // guarded by mutex; null before a tick
+  const std::string unavailable;
+  const std::string not_found;
+  const std::string not_allowed;
+};
+
+#endif
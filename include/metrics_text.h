@@ -0,0 +1,39 @@
+#ifndef METRICS_TEXT_H
+#define METRICS_TEXT_H
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "group_by.h"
+#include "process.h"
+#include "system_snapshot.h"
+#include "top_processes.h"
+
+/*
+Prometheus text exposition of a snapshot
+Host CPU, memory and process counts, totals per user and per cgroup,
+and single processes only for the top n by CPU and the top n by RSS, so
+the number of series stays bounded however many processes run. Numbers
+are formatted with std::to_chars into the caller's string, which keeps
+its capacity from tick to tick.
+*/
+class MetricsText {
+ public:
+  explicit MetricsText(std::size_t top);
+  // Replace output with the exposition of snapshot
+  void Write(const SystemSnapshot& snapshot, std::string& output);
+
+ private:
+  const std::size_t top;
+  TopProcesses by_cpu = {};
+  TopProcesses by_rss = {};
+  GroupBy group_by = {};
+  std::vector<Process> selected = {};  // PID order, no duplicates
+  std::string labels = {};             // of selected, back to back
+  std::vector<std::size_t> ends = {};  // end of each one's labels
+  std::string label = {};
+};
+
+#endif
@@ -2,15 +2,47 @@
 #define NCURSES_DISPLAY_H
 
 #include <curses.h>
+#include <chrono>
+#include <cstddef>
+#include <string_view>
+#include <vector>
 
+#include "canvas.h"
+#include "cgroup_snapshot.h"
+#include "group_by.h"
 #include "process.h"
-#include "system.h"
+#include "process_table.h"
+#include "process_tree.h"
+#include "snapshot_source.h"
+#include "system_snapshot.h"
+#include "top_processes.h"
 
 namespace NCursesDisplay {
-void Display(System& system, int n = 10);
-void DisplaySystem(System& system, WINDOW* window);
-void DisplayProcesses(std::vector<Process>& processes, WINDOW* window, int n);
-std::string ProgressBar(float percent);
+// Fixed buffer every line of text is formatted into before drawing
+constexpr std::size_t kLineSize{256};
+using LineBuffer = char[kLineSize];
+
+void Display(SnapshotSource& source, std::chrono::milliseconds render_interval,
+             int n = 10);
+void DisplaySystem(const SystemSnapshot& system, Canvas& canvas);
+// Draw the per-core strip from row on; returns its last row
+int DisplayCores(const std::vector<float>& cores, Canvas& canvas, int row);
+void DisplayInstrumentation(Canvas& canvas);
+// Rows the strip takes in a window that many columns wide
+int CoreRows(std::size_t cores, int columns);
+void DisplayProcesses(std::vector<Process>& processes, Canvas& canvas, int n,
+                      SortKey sorting);
+// Totals per group instead of single processes, from the 'a' key
+void DisplayGroups(const std::vector<Group>& groups, const ProcessTable& table,
+                   GroupKey key, Canvas& canvas, int n, SortKey sorting);
+// Parent/child tree with subtree totals, from the 'f' key
+void DisplayTree(const std::vector<ProcessTree::Row>& rows, Canvas& canvas,
+                 int n, int first, int selected);
+// Resource use per cgroup, from the 'C' key; cgroups in display order
+void DisplayCgroups(const std::vector<const CgroupSnapshot*>& cgroups,
+                    Canvas& canvas, int n, SortKey sorting);
+bool SortKeyFor(int key, SortKey& sorting);
+std::string_view ProgressBar(float percent, LineBuffer& line);
 };  // namespace NCursesDisplay
 
 #endif
\ No newline at end of file
@@ -0,0 +1,44 @@
+#ifndef OPTIONS_H
+#define OPTIONS_H
+
+#include <chrono>
+#include <cstddef>
+#include <string>
+
+/*
+Command line settings of the monitor
+ParseOptions throws std::invalid_argument on unknown or malformed flags
+*/
+enum class OutputFormat { kCsv, kJson };
+
+struct Options {
+  bool help{false};
+  bool batch{false};     // --batch: stream samples instead of the UI
+  long iterations{0};    // -n N, 0 means until interrupted
+  OutputFormat format{OutputFormat::kCsv};
+  int threads{1};  // --threads N, 0 means one per core
+  bool instrument{false};  // --instrument: time the monitor, dump on exit
+  bool events{false};  // --events: track processes via the proc connector
+  int memory_interval{4};  // --memory-interval N: ticks between statm reads
+  int budget{0};  // --budget PERCENT of one CPU per tick, 0 for none
+  std::chrono::milliseconds sample_interval{1000};  // also -d SEC
+  std::chrono::milliseconds render_interval{250};
+  std::string record{};                // --record FILE
+  std::size_t record_size{256 << 20};  // --record-size MB
+  std::string replay{};                // --replay FILE
+  bool publish{false};  // --publish: sample for --attach viewers, no UI
+  bool attach{false};   // --attach: show what a publisher samples
+  std::string shm_name{"monitor"};     // --shm NAME, below /dev/shm
+  std::size_t shm_size{64 << 20};      // --shm-size MB
+  std::string listen{};  // --listen ADDR:PORT: serve /metrics, no UI
+  std::size_t metrics_top{10};         // --metrics-top N
+  std::string filter{};                // --filter EXPR, see ProcessFilter
+  std::string proc_root{"/proc"};      // --proc-root DIR
+  std::string etc_root{"/etc"};        // --etc-root DIR
+  std::string cgroup_root{"/sys/fs/cgroup"};  // --cgroup-root DIR
+};
+
+Options ParseOptions(int argc, char* argv[]);
+std::string Usage(const std::string& program);
+
+#endif
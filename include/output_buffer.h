@@ -0,0 +1,45 @@
+#ifndef OUTPUT_BUFFER_H
+#define OUTPUT_BUFFER_H
+
+#include <cstddef>
+#include <string_view>
+#include <vector>
+
+/*
+Buffered writer to a file descriptor
+Numbers are formatted with std::to_chars straight into the buffer, so
+appending fields never allocates; the buffer is written out with
+write(2) when it fills up and on Flush
+*/
+class OutputBuffer {
+ public:
+  explicit OutputBuffer(int descriptor, std::size_t capacity = 1 << 16);
+  ~OutputBuffer();
+  OutputBuffer(const OutputBuffer&) = delete;
+  OutputBuffer& operator=(const OutputBuffer&) = delete;
+
+  void Append(std::string_view text);
+  void Append(char character);
+  void Append(long value);
+  void Append(unsigned long value);
+  void Append(int value);
+  // Fixed notation with the given number of decimals
+  void Append(double value, int precision);
+  // text quoted and escaped for JSON
+  void AppendJson(std::string_view text);
+  // text quoted for CSV when it holds a separator, quote or line break
+  void AppendCsv(std::string_view text);
+  // Returns false once a write failed; later output is dropped
+  bool Flush();
+
+ private:
+  // Make room for at least size more bytes
+  void Reserve(std::size_t size);
+
+  int descriptor;
+  std::vector<char> buffer;
+  std::size_t length = 0;
+  bool failed = false;
+};
+
+#endif
@@ -0,0 +1,44 @@
+#ifndef PROC_EVENTS_H
+#define PROC_EVENTS_H
+
+#include <cstdint>
+#include <vector>
+
+struct proc_event;
+
+/*
+Subscription to the kernel's process events (netlink proc connector)
+Fork events keep a PID list up to date without listing /proc, and exec
+and exit events tell which command lines changed. Subscribing works
+only in the initial namespaces and, before Linux 6.6, needs
+CAP_NET_ADMIN. When the socket overflows or sequence numbers skip,
+events were lost and the caller has to rebuild its list from a scan.
+*/
+class ProcEvents {
+ public:
+  // Throws std::runtime_error when the subscription is refused or not
+  // acknowledged in time
+  ProcEvents();
+  ~ProcEvents();
+  ProcEvents(const ProcEvents&) = delete;
+  ProcEvents& operator=(const ProcEvents&) = delete;
+
+  // Apply every pending event to pids (ascending) and append the PIDs
+  // that exec'd or exited to stale. Returns false when pids cannot be
+  // trusted: on the first call and after events were lost. The events
+  // are still applied, so a rescan followed by the next Poll catches up.
+  bool Poll(std::vector<int>& pids, std::vector<int>& stale);
+
+ private:
+  // Wait for the kernel's answer to the subscription; 0 or an errno
+  int Acknowledgement();
+  void Apply(const proc_event& event, std::vector<int>& stale);
+
+  int socket_fd{-1};
+  bool lost{true};
+  std::vector<uint32_t> sequences{};  // next expected, per CPU
+  std::vector<char> seen{};           // per CPU
+  std::vector<int> added{};           // forked during one Poll
+};
+
+#endif
@@ -0,0 +1,96 @@
+#ifndef PROC_READER_H
+#define PROC_READER_H
+
+#include <charconv>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/*
+Reads /proc files into one reusable buffer with open/read
+Once the buffer has grown to fit the largest file, reading and parsing
+a file costs no heap allocation. Views returned by Read stay valid until
+the next call on the same reader.
+*/
+class ProcReader {
+ public:
+  explicit ProcReader(std::size_t capacity = 4096);
+  bool Read(const char* path, std::string_view& content);
+  bool Read(const std::string& path, std::string_view& content);
+  // Read /proc/<filename>, e.g. ReadProc(kStatFilename, content), below the
+  // configured proc root
+  bool ReadProc(const std::string& filename, std::string_view& content);
+  // Read /proc/<pid>/<filename>, e.g. Read(1, kStatFilename, content)
+  bool Read(int pid, const std::string& filename, std::string_view& content);
+
+ private:
+  std::vector<char> buffer;
+  std::string path;
+};
+
+// Fields of /proc/<pid>/stat the monitor uses
+struct PidStat {
+  std::string_view comm{};
+  char state{'?'};
+  int ppid{0};        // field 4
+  long utime{0};      // field 14
+  long stime{0};      // field 15
+  long starttime{0};  // field 22
+};
+
+// /proc/<pid>/statm, in pages
+struct PidStatm {
+  long size{0};
+  long resident{0};
+  long shared{0};
+};
+
+// /proc/<pid>/smaps_rollup, in kB
+struct PidSmaps {
+  long pss{0};
+  long private_clean{0};
+  long private_dirty{0};
+};
+
+namespace ProcParse {
+// Skip blanks, parse the integer in front of text and advance past it
+template <typename T>
+bool Number(std::string_view& text, T& value) {
+  std::size_t start = text.find_first_not_of(" \t\n");
+  if (start == std::string_view::npos) return false;
+  const char* first = text.data() + start;
+  const char* last = text.data() + text.size();
+  auto result = std::from_chars(first, last, value);
+  if (result.ec != std::errc()) return false;
+  text.remove_prefix(result.ptr - text.data());
+  return true;
+}
+
+// Skip count blank separated fields
+void Skip(std::string_view& text, int count);
+
+// Cut the next line off text, without its newline
+std::string_view Line(std::string_view& text);
+
+// Number following "key:" at the start of a line (status, meminfo)
+template <typename T>
+bool KeyValue(std::string_view content, std::string_view key, T& value) {
+  while (!content.empty()) {
+    std::string_view line = Line(content);
+    if (line.size() > key.size() && line[key.size()] == ':' &&
+        line.compare(0, key.size(), key) == 0) {
+      line.remove_prefix(key.size() + 1);
+      return Number(line, value);
+    }
+  }
+  return false;
+}
+
+// comm may hold spaces and parentheses, so fields restart after the last ')'
+bool Stat(std::string_view content, PidStat& stat);
+bool Statm(std::string_view content, PidStatm& statm);
+// One pass over the "Key: N kB" lines, false when Pss is missing
+bool Smaps(std::string_view content, PidSmaps& smaps);
+};  // namespace ProcParse
+
+#endif
@@ -2,24 +2,36 @@
 #define PROCESS_H
 
 #include <string>
+#include <string_view>
+
+#include "process_snapshot.h"
+
 /*
 Basic class for Process representation
-It contains relevant attributes as shown below
+It is a cheap view over a ProcessSnapshot taken during the current tick,
+so none of the getters touch the filesystem
 */
 class Process {
  public:
-  Process(long input_pid) : pid(input_pid){};
+  explicit Process(const ProcessSnapshot& input_snapshot)
+      : snapshot(&input_snapshot){};
   int GetPid() const;
-  std::string GetUid() const; 
-  std::string GetUser() const;
-  std::string GetCommand() const;
+  std::string GetUid() const;
+  std::string_view GetUser() const;
+  std::string_view GetCommand() const;
+  std::string_view GetName() const;  // stat's comm
   float GetCpuUtilization() const;
-  std::string GetRam() const;
+  std::string GetRam() const;  // MB, resident
+  long GetVsz() const;         // kB
+  long GetRss() const;         // kB
+  long GetShared() const;      // kB
+  long GetPss() const;         // kB, -1 when smaps_rollup was not read
+  long GetUss() const;         // kB, likewise
   long int GetUpTime() const;
   bool operator<(Process const& process) const;
 
  private:
-   long pid;
+  const ProcessSnapshot* snapshot;
 };
 
-#endif
\ No newline at end of file
+#endif
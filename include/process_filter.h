@@ -0,0 +1,69 @@
+#ifndef PROCESS_FILTER_H
+#define PROCESS_FILTER_H
+
+#include <regex>
+#include <string>
+#include <vector>
+
+#include "process_snapshot.h"
+#include "user_cache.h"
+
+/*
+Which processes to show, e.g. "user=www cmd~nginx cpu>5"
+Space separated terms that must all hold:
+  user=NAME  uid=N  name~REGEX (stat's comm)  cmd~REGEX (command line)
+  state=LETTERS (any of them)  cpu>PERCENT  mem>MB (RSS)
+Text fields take = ~ and numbers = < >; a leading ! on the operator
+negates the term. Regular expressions are compiled once, when the text
+is parsed. Each term depends on one file of /proc/<pid>, so the sampler
+can read those files cheapest first and stop at the first term that
+fails; CPU terms need the interval usage and are checked last.
+*/
+class ProcessFilter {
+ public:
+  // Not one of LinuxParser::ProcessFields: the CPU share since the last
+  // tick, known once the stat of two ticks has been compared
+  static constexpr unsigned kUsage = 1u << 16;
+
+  ProcessFilter() = default;
+  // Throws std::invalid_argument naming the first term that does not parse
+  explicit ProcessFilter(const std::string& text);
+
+  bool Empty() const;
+  const std::string& Text() const;
+  // LinuxParser::ProcessFields and kUsage the terms look at
+  unsigned Fields() const;
+  // True when every term is on the user, name or command line, which
+  // change only with an exec, so a rejected process stays rejected
+  bool Lasting() const;
+  // Look up the uids of user terms; once per tick, before any Match
+  void Resolve(UserCache& users);
+  // Check the terms on the given fields that are not in checked yet and
+  // add the fields to checked; false as soon as one fails. Safe to call
+  // from several threads once resolved.
+  bool Match(const ProcessSnapshot& process, unsigned fields,
+             unsigned& checked) const;
+
+ private:
+  enum class Field { kUser, kUid, kName, kCommand, kState, kCpu, kMemory };
+
+  struct Term {
+    Field field;
+    unsigned source;  // ProcessFields or kUsage it is read from
+    char operation;   // '=', '~', '<' or '>'
+    bool negated;
+    std::string text;
+    std::regex pattern;
+    double number;
+    int uid;  // of a user term, -1 for none
+  };
+
+  static Term Parse(const std::string& term);
+  static bool Holds(const Term& term, const ProcessSnapshot& process);
+
+  std::string text = {};
+  std::vector<Term> terms = {};  // cheapest source first
+  unsigned fields = 0;
+};
+
+#endif
@@ -0,0 +1,34 @@
+#ifndef PROCESS_SNAPSHOT_H
+#define PROCESS_SNAPSHOT_H
+
+#include <string>
+#include <string_view>
+
+/*
+Plain record holding everything the monitor shows about one process.
+Its fields are read from /proc/<pid>/stat, statm, status and cmdline,
+each on its own cadence (see RefreshSchedule); smaps_rollup only for
+the processes on screen. user and command view text owned elsewhere;
+in a SystemSnapshot, by its arena.
+*/
+struct ProcessSnapshot {
+  int pid{0};
+  int ppid{0};          // 0 for the roots, init and kthreadd
+  int uid{-1};
+  std::string_view user{};
+  std::string_view command{};
+  std::string name{};   // stat's comm, at most 15 characters
+  char state{'?'};      // stat's R, S, D, Z...
+  long vsz{0};          // kB, statm size
+  long rss{0};          // kB, statm resident
+  long shared{0};       // kB, resident pages backed by a file or shmem
+  long pss{-1};         // kB, RSS with shared pages split among users;
+  long uss{-1};         // kB, private pages; both -1 until read
+  long utime{0};        // jiffies
+  long stime{0};        // jiffies
+  long starttime{0};    // jiffies after boot
+  long uptime{0};       // seconds since the process started
+  float cpu_utilization{0};
+};
+
+#endif
@@ -0,0 +1,57 @@
+#ifndef PROCESS_TABLE_H
+#define PROCESS_TABLE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#include "process_snapshot.h"
+
+/*
+Column-wise copy of a snapshot's processes, for aggregations
+Each field is one contiguous array, so a pass over a field of 100k
+processes streams through memory. User names and command lines are
+replaced by dense ids into users and commands, and the parent by its
+row, so grouping needs no hashing. The texts view the snapshot's.
+*/
+struct ProcessTable {
+  static constexpr uint32_t kNoParent = UINT32_MAX;
+
+  std::vector<int> pid{};
+  std::vector<uint32_t> user{};     // index into users
+  std::vector<uint32_t> command{};  // index into commands
+  std::vector<uint32_t> parent{};   // row of the parent or kNoParent
+  std::vector<float> cpu{};         // share of one CPU
+  std::vector<int64_t> rss{};       // kB
+  std::vector<int64_t> vsz{};       // kB
+  std::vector<std::string_view> users{};
+  std::vector<std::string_view> commands{};
+
+  std::size_t Size() const { return pid.size(); }
+};
+
+// Fills tables from processes in PID order; its lookup storage is kept
+// between calls, so a steady state build does not allocate
+class ProcessTableBuilder {
+ public:
+  void Build(const std::vector<ProcessSnapshot>& processes,
+             ProcessTable& table);
+
+ private:
+  // Open addressing from text to its index in texts
+  class Dictionary {
+   public:
+    void Reset(std::size_t capacity, std::vector<std::string_view>& texts);
+    uint32_t Id(std::string_view text);
+
+   private:
+    std::vector<uint32_t> slots = {};  // id + 1, 0 when empty
+    std::vector<std::string_view>* texts = nullptr;
+  };
+
+  Dictionary users = {};
+  Dictionary commands = {};
+};
+
+#endif
@@ -0,0 +1,80 @@
+#ifndef PROCESS_TREE_H
+#define PROCESS_TREE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "process_snapshot.h"
+
+/*
+Parent/child tree of the processes, kept from one snapshot to the next
+Update diffs a snapshot against the nodes it already holds: new PIDs are
+linked under their parent, gone ones are unlinked, reparented ones are
+moved, and only the change of a process's CPU and RSS is pushed up its
+ancestors. Every node thus carries the totals of its subtree without
+the tree ever being rebuilt. Collapsed branches stay collapsed for as
+long as their process lives.
+*/
+class ProcessTree {
+ public:
+  // One line of the expanded part of the tree
+  struct Row {
+    const ProcessSnapshot* process;  // valid until the next Update
+    int depth;
+    double cpu;    // share of one CPU, the subtree's total
+    int64_t rss;   // kB, the subtree's total
+    bool parent;   // has children
+    bool collapsed;
+  };
+
+  // Bring the tree in line with processes, which are in PID order
+  void Update(const std::vector<ProcessSnapshot>& processes);
+  // Depth-first, children in the order they appeared, collapsed
+  // branches left out
+  const std::vector<Row>& Rows();
+  // Show or hide the children of pid
+  void Collapse(int pid, bool collapsed);
+  std::size_t Size() const;
+
+ private:
+  static constexpr uint32_t kNone = UINT32_MAX;
+  static constexpr uint32_t kRoot = 0;  // above every process
+
+  struct Node {
+    int pid{0};
+    int ppid{0};
+    long starttime{0};
+    uint32_t row{0};  // index into the last processes
+    uint32_t parent{kNone};
+    uint32_t first_child{kNone};
+    uint32_t last_child{kNone};
+    uint32_t previous{kNone};
+    uint32_t next{kNone};
+    float cpu{0};     // own values, as last seen
+    int64_t rss{0};
+    double subtree_cpu{0};
+    int64_t subtree_rss{0};
+    bool collapsed{false};
+  };
+
+  uint32_t Create(const ProcessSnapshot& process, uint32_t row);
+  void Remove(uint32_t node);
+  uint32_t Find(int pid) const;
+  void Attach(uint32_t node, uint32_t parent);
+  void Detach(uint32_t node);
+  // Add to the subtree totals of node and every ancestor of it
+  void Propagate(uint32_t node, double cpu, int64_t rss);
+
+  std::vector<Node> nodes = {};
+  std::vector<uint32_t> unused = {};
+  std::vector<uint32_t> by_pid = {};  // live nodes in PID order
+  std::vector<uint32_t> next_by_pid = {};
+  std::vector<uint32_t> added = {};
+  std::vector<uint32_t> moved = {};
+  std::vector<uint32_t> stack = {};
+  std::vector<Row> rows = {};
+  const std::vector<ProcessSnapshot>* processes = nullptr;
+};
+
+#endif
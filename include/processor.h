@@ -1,11 +1,29 @@
 #ifndef PROCESSOR_H
 #define PROCESSOR_H
 
+#include <cstdint>
+#include <vector>
+
+#include "linux_parser.h"
+
+/*
+Aggregate and per-core CPU usage computed from the delta between two
+/proc/stat samples, so no sleeping is needed between reads
+*/
 class Processor {
  public:
-  float Utilization();
+  void Update(const LinuxParser::CpuTimes& times);
+  void Update(const LinuxParser::CoreTimes& cores);
+  float Utilization() const;
+  // Busy fraction of every core over the last tick, in /proc/stat order
+  const std::vector<float>& CoreUtilization() const;
 
  private:
+  LinuxParser::CpuTimes previous = {};
+  float utilization = 0;
+  std::vector<uint64_t> previous_busy = {};
+  std::vector<uint64_t> previous_total = {};
+  std::vector<float> cores = {};
 };
 
-#endif
\ No newline at end of file
+#endif
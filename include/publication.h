@@ -0,0 +1,65 @@
+#ifndef PUBLICATION_H
+#define PUBLICATION_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/*
+Layout of the shared memory segment, shared by Publisher and Subscriber
+A Header is followed by kSlots slots of `capacity` bytes, each holding
+one keyframe encoded by SnapshotEncoder. The publisher writes the slot
+after the newest one and then advances `latest`, so readers of the
+newest slot are only disturbed when they take longer than a whole tick.
+Each slot is a seqlock: its sequence is odd while it is being written,
+and a reader keeps what it decoded only when the sequence was even and
+unchanged around the read. The publisher is identified by its PID and
+start time, since a PID is reused once its process is gone.
+*/
+namespace Publication {
+constexpr char kMagic[8] = "MONPUB1";
+constexpr uint32_t kVersion{2};
+constexpr std::size_t kSlots{2};
+constexpr std::size_t kAlignment{64};
+
+// Both sides map the same atomics, which only works without locks
+static_assert(std::atomic<uint64_t>::is_always_lock_free,
+              "shared atomics need lock-free 64 bit operations");
+
+struct Slot {
+  std::atomic<uint64_t> sequence;
+  uint64_t size;  // payload bytes
+  uint64_t tick;
+  int64_t timestamp_ms;
+};
+
+struct Header {
+  char magic[8];
+  uint32_t version;
+  uint32_t codec_version;  // Recording::kVersion of the payloads
+  uint64_t header_size;
+  uint64_t capacity;  // bytes per slot
+  int64_t publisher;  // PID of the process writing the segment
+  int64_t publisher_start;  // its start time, jiffies after boot
+  std::atomic<uint64_t> latest;  // ticks published; latest % kSlots is newest
+  Slot slots[kSlots];
+};
+
+// Offset of slot index's payload from the start of the segment
+constexpr uint64_t Offset(uint64_t header_size, uint64_t capacity,
+                          std::size_t index) {
+  return header_size + index * capacity;
+}
+
+// Bytes in front of the first slot, rounded up to kAlignment
+constexpr uint64_t HeaderSize() {
+  return (sizeof(Header) + kAlignment - 1) & ~(kAlignment - 1);
+}
+
+// Start time of pid from /proc/<pid>/stat, -1 when it cannot be read
+int64_t StartTime(int64_t pid);
+// Whether pid still is the process that started at start
+bool Running(int64_t pid, int64_t start);
+};  // namespace Publication
+
+#endif
@@ -0,0 +1,41 @@
+#ifndef PUBLISHER_H
+#define PUBLISHER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "publication.h"
+#include "snapshot_codec.h"
+#include "system_snapshot.h"
+
+/*
+Publishes every snapshot into a POSIX shared memory segment (see
+publication.h) for any number of Subscribers to map read-only
+Each tick costs one encoding and one memcpy, however many viewers there
+are. The segment is readable by everyone and removed again when the
+publisher goes away.
+*/
+class Publisher {
+ public:
+  // Creates the segment /name of capacity bytes in total; throws
+  // std::runtime_error when it cannot, or when a live publisher already
+  // uses the name
+  Publisher(const std::string& name, std::size_t capacity);
+  ~Publisher();
+  Publisher(const Publisher&) = delete;
+  Publisher& operator=(const Publisher&) = delete;
+
+  void Publish(const SystemSnapshot& snapshot);
+
+ private:
+  const std::string name;
+  Publication::Header* header{nullptr};
+  std::size_t length{0};
+  SnapshotEncoder encoder{};
+  std::vector<uint8_t> payload{};
+  bool warned{false};  // about a snapshot too large for a slot
+};
+
+#endif
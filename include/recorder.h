@@ -0,0 +1,44 @@
+#ifndef RECORDER_H
+#define RECORDER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "recording.h"
+#include "snapshot_codec.h"
+#include "system_snapshot.h"
+
+/*
+Appends every snapshot to a memory-mapped ring file (see recording.h)
+Snapshots are delta encoded, with a keyframe every KEYFRAME_INTERVAL
+records so a replay can seek without decoding from the start. Writing
+is a memcpy into the mapping; the kernel flushes the pages in the
+background, so a tick never waits for the disk.
+*/
+class Recorder {
+ public:
+  // Creates or truncates path; throws std::runtime_error on failure
+  Recorder(const std::string& path, std::size_t capacity);
+  ~Recorder();
+  Recorder(const Recorder&) = delete;
+  Recorder& operator=(const Recorder&) = delete;
+
+  void Append(const SystemSnapshot& snapshot);
+
+ private:
+  uint8_t* Ring(uint64_t offset) const;
+  void Evict();
+  uint64_t Reserve(uint64_t span);
+
+  Recording::FileHeader* header{nullptr};
+  std::size_t length{0};
+  SnapshotEncoder encoder{};
+  std::vector<uint8_t> payload{};
+  unsigned long since_keyframe{0};
+  unsigned long keyframes{0};  // in the ring
+  bool keyframe{true};
+};
+
+#endif
@@ -0,0 +1,45 @@
+#ifndef RECORDING_H
+#define RECORDING_H
+
+#include <cstddef>
+#include <cstdint>
+
+/*
+Layout of a recording file, shared by Recorder and Replayer
+A FileHeader is followed by a ring of `capacity` bytes. Each record is a
+RecordHeader and an encoded snapshot, padded to 8 bytes. When a record
+does not fit before the end of the ring, a wrap marker (or fewer bytes
+than a RecordHeader) tells readers to continue at offset 0. The oldest
+records are overwritten as the ring fills.
+*/
+namespace Recording {
+constexpr char kMagic[8] = "MONREC1";
+constexpr uint32_t kVersion{7};
+constexpr std::size_t kAlignment{8};
+
+enum Flags : uint32_t { kKeyframe = 1 << 0, kWrap = 1 << 1 };
+
+struct FileHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t header_size;
+  uint64_t capacity;  // bytes in the ring
+  uint64_t head;      // ring offset the next record goes to
+  uint64_t tail;      // ring offset of the oldest record
+  uint64_t records;
+};
+
+struct RecordHeader {
+  uint32_t size;  // payload bytes, without header and padding
+  uint32_t flags;
+  uint64_t tick;
+  int64_t timestamp_ms;
+};
+
+// Bytes a record with size payload bytes takes in the ring
+constexpr uint64_t Span(uint64_t size) {
+  return (sizeof(RecordHeader) + size + kAlignment - 1) & ~(kAlignment - 1);
+}
+};  // namespace Recording
+
+#endif
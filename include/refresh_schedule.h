@@ -0,0 +1,92 @@
+#ifndef REFRESH_SCHEDULE_H
+#define REFRESH_SCHEDULE_H
+
+#include <chrono>
+#include <cstddef>
+#include <vector>
+
+#include "linux_parser.h"
+#include "process_snapshot.h"
+#include "string_pool.h"
+
+/*
+Decides which fields of which process are read on a tick
+CPU times are read every tick, memory every few ticks, and the user and
+command line once per process or again after an exec. Busy processes
+and the ones on screen get their memory read every tick too, and only
+those have their smaps_rollup read at all. When a tick costs more CPU
+time than the budget, idle processes are read on every second,
+fourth... tick until it fits again; in between they show what was read
+last. Command lines are kept interned, one copy per distinct text.
+*/
+class RefreshSchedule {
+ public:
+  struct Settings {
+    unsigned memory_interval;          // ticks between statm reads
+    std::chrono::microseconds budget;  // CPU time per tick, 0: unlimited
+  };
+
+  explicit RefreshSchedule(Settings settings);
+  // Line the per-process state up with this tick's PIDs (ascending)
+  void Begin(const std::vector<int>& pids, long uptime);
+  // Read the user and command line of pid again, e.g. after an exec
+  void Invalidate(int pid);
+  // PIDs on screen, refreshed like busy ones
+  void Prioritize(const std::vector<int>& pids);
+
+  // LinuxParser::ProcessFields to read for the i-th PID; 0 defers it
+  unsigned Due(std::size_t i) const;
+  // Fields that also have to be read because stat shows a different
+  // process than the one remembered: a reused PID or an exec
+  unsigned Missing(std::size_t i, const ProcessSnapshot& snapshot,
+                   unsigned fields) const;
+  // Remember the fields read into snapshot and fill in the others from
+  // earlier ticks; may be called again as more fields are read
+  void Merge(std::size_t i, unsigned fields, ProcessSnapshot& snapshot);
+  // Fields that were due but left unread, e.g. because a filter rejected
+  // the process first; they stay due until they are read
+  void Skip(std::size_t i, unsigned fields);
+  // Fields of the i-th PID read at least once for the current process
+  unsigned Known(std::size_t i) const;
+  // The filter rejected the i-th PID on what only an exec changes: read
+  // only its stat, at the idle period, until ShowAll, an Invalidate of
+  // its PID or an exec seen in stat. Processes younger than a few
+  // seconds are not hidden yet.
+  void Hide(std::size_t i);
+  void ShowAll();
+  // Remember the CPU share the i-th PID used during this tick
+  void Used(std::size_t i, float cpu_utilization);
+  // Interned command line of the i-th PID, valid until its next Begin
+  StringPool::Entry Command(std::size_t i) const;
+  const StringPool& Commands() const;
+
+  // Adjust the cadence to the CPU time this tick took
+  void Finish(std::chrono::nanoseconds used);
+  // Ticks between reads of idle processes, 1 while within the budget
+  unsigned Period() const;
+
+ private:
+  struct Slot {
+    ProcessSnapshot process{};
+    StringPool::Entry command{};
+    unsigned unread{LinuxParser::kAllFields};
+    bool busy{false};
+    bool visible{false};
+    bool hidden{false};
+  };
+
+  const Settings settings;
+  StringPool commands = {};
+  // Aligned with the PIDs of the current tick; spare is the previous
+  // tick's storage, swapped in so the strings keep their capacity. Only
+  // the first count slots hold references on commands.
+  std::vector<Slot> slots = {};
+  std::vector<Slot> spare = {};
+  std::size_t count = 0;
+  std::vector<int> visible = {};
+  unsigned long tick = 0;
+  long uptime = 0;
+  unsigned level = 0;
+};
+
+#endif
@@ -0,0 +1,69 @@
+#ifndef REPLAYER_H
+#define REPLAYER_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "process_table.h"
+#include "recording.h"
+#include "snapshot_codec.h"
+#include "snapshot_source.h"
+#include "system_snapshot.h"
+
+/*
+Plays a file written by Recorder back through the display
+Ticks follow the recorded timestamps. Keys: space pauses, '.' and ','
+step one tick, ']' and '[' jump a minute of ticks, 'g' and 'G' go to the
+first and last tick.
+*/
+class Replayer : public SnapshotSource {
+ public:
+  // Throws std::runtime_error when path is not a usable recording, also
+  // later when no record in it turns out to decode
+  explicit Replayer(const std::string& path);
+  ~Replayer();
+  Replayer(const Replayer&) = delete;
+  Replayer& operator=(const Replayer&) = delete;
+
+  void Start() override;
+  void Stop() override;
+  bool Update() override;
+  const SystemSnapshot& Latest() const override;
+  bool HandleKey(int key) override;
+  std::string_view Status() const override;
+
+ private:
+  struct Entry {
+    uint64_t offset;  // of the payload in the file
+    Recording::RecordHeader header;
+  };
+
+  void Seek(std::size_t target);
+  void Play(std::size_t from, std::size_t target);
+  std::size_t Keyframe(std::size_t index) const;
+  // Remove entries[index] and the deltas up to the next keyframe
+  void Drop(std::size_t index);
+  // False, with the snapshot half updated, when the record is malformed
+  bool Decode(std::size_t index);
+  void Anchor();
+  void Describe();
+
+  const uint8_t* data{nullptr};
+  std::size_t length{0};
+  std::vector<Entry> entries{};
+  SnapshotDecoder decoder{};
+  ProcessTableBuilder tables{};
+  SystemSnapshot snapshot{};
+  std::size_t position{0};
+  std::size_t dropped{0};  // entries removed because they did not decode
+  bool paused{false};
+  // Playback time of entries[position] is anchor_time
+  std::chrono::steady_clock::time_point anchor_time{};
+  std::string status{};
+};
+
+#endif
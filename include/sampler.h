@@ -0,0 +1,76 @@
+#ifndef SAMPLER_H
+#define SAMPLER_H
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "process_filter.h"
+#include "snapshot_source.h"
+#include "system.h"
+#include "system_snapshot.h"
+#include "triple_buffer.h"
+
+/*
+Runs System::Refresh on a background thread at a fixed interval
+Each tick is published through a triple buffer, so the display reads
+the latest complete snapshot without ever blocking the sampler
+*/
+class Sampler : public SnapshotSource {
+ public:
+  // Called on the sampling thread with every new snapshot, before the
+  // display can see it
+  using Listener = std::function<void(const SystemSnapshot&)>;
+
+  Sampler(System& system, std::chrono::milliseconds interval);
+  ~Sampler();
+  Sampler(const Sampler&) = delete;
+  Sampler& operator=(const Sampler&) = delete;
+
+  // Listeners must be added before Start
+  void AddListener(Listener listener);
+  // Take the first sample synchronously, then keep sampling in the background
+  void Start() override;
+  void Stop() override;
+  // Sample once on the calling thread and adopt the result; for callers
+  // that pace sampling themselves instead of calling Start
+  void Step();
+  // Reader side: adopt the newest published snapshot, if any; returns
+  // true when Latest() changed. Only the display thread may call these.
+  bool Update() override;
+  const SystemSnapshot& Latest() const override;
+  // Handed to the system before its next tick
+  void Prioritize(const std::vector<int>& pids) override;
+  // Handed to the system before its next tick
+  bool FilterBy(const ProcessFilter& filter) override;
+  std::string_view Filter() const override;
+  // Tells when idle processes are read less often to stay in budget
+  std::string_view Status() const override;
+
+ private:
+  void Run();
+  void Sample();
+
+  System& system;
+  const std::chrono::milliseconds interval;
+  std::vector<Listener> listeners = {};
+  TripleBuffer<SystemSnapshot> buffers = {};
+  std::thread thread = {};
+  std::mutex mutex = {};
+  std::condition_variable wake = {};
+  bool stopping = false;
+  std::vector<int> visible = {};  // guarded by mutex
+  ProcessFilter filter = {};      // guarded by mutex
+  bool filter_changed = false;    // guarded by mutex
+  // Display thread only
+  unsigned period = 1;
+  std::string status = {};
+  std::string filter_text = {};
+};
+
+#endif
@@ -0,0 +1,48 @@
+#ifndef SCAN_POOL_H
+#define SCAN_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+Small work-sharing pool for the /proc scan
+ForEach splits [0, count) into chunks that idle threads claim from a
+shared atomic cursor; the calling thread works too, so a pool of size 1
+runs everything inline without any synchronisation
+*/
+class ScanPool {
+ public:
+  using Task = std::function<void(std::size_t begin, std::size_t end)>;
+
+  explicit ScanPool(int threads = 1);
+  ~ScanPool();
+  ScanPool(const ScanPool&) = delete;
+  ScanPool& operator=(const ScanPool&) = delete;
+
+  // Run task over every chunk of [0, count) and wait for all of them
+  void ForEach(std::size_t count, const Task& task);
+  int Size() const;
+
+ private:
+  void Work();
+  void RunChunks();
+
+  std::vector<std::thread> workers = {};
+  std::mutex mutex = {};
+  std::condition_variable wake = {};
+  std::condition_variable finished = {};
+  const Task* task = nullptr;
+  std::size_t count = 0;
+  std::size_t chunk = 1;
+  std::atomic<std::size_t> cursor{0};
+  unsigned long generation = 0;
+  int busy = 0;
+  bool stopping = false;
+};
+
+#endif
@@ -0,0 +1,53 @@
+#ifndef SNAPSHOT_CODEC_H
+#define SNAPSHOT_CODEC_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "arena.h"
+#include "cgroup_snapshot.h"
+#include "process_snapshot.h"
+#include "system_snapshot.h"
+
+/*
+Compact binary encoding of snapshots as differences to the previous one
+Integers are LEB128 varints of the change since the last tick, and a
+process that did not change costs nothing. A keyframe is the difference
+to an empty snapshot, so decoding can start at any keyframe. Per-core
+utilization is rounded to 0.1 %. Cgroups follow the processes, each as
+the difference to the cgroup at its index in the previous snapshot.
+*/
+class SnapshotEncoder {
+ public:
+  // Append the encoding of snapshot to output
+  void Encode(const SystemSnapshot& snapshot, bool keyframe,
+              std::vector<uint8_t>& output);
+
+ private:
+  std::vector<ProcessSnapshot> previous = {};  // PID order
+  std::vector<CgroupSnapshot> previous_cgroups = {};
+  // Text of previous, and the one it is copied into next
+  Arena strings = {};
+  Arena spare = {};
+  std::vector<std::size_t> order = {};
+  std::vector<uint8_t> removed = {};
+  std::vector<uint8_t> changed = {};
+};
+
+class SnapshotDecoder {
+ public:
+  // Apply one encoded record to snapshot, which must hold the result of
+  // the previous record unless this one is a keyframe. Processes come out
+  // in PID order, their text in the snapshot's arena, which only a
+  // keyframe resets. Returns false when the record is malformed.
+  bool Decode(const uint8_t* data, std::size_t size, bool keyframe,
+              SystemSnapshot& snapshot);
+
+ private:
+  std::vector<ProcessSnapshot> next = {};
+  std::vector<int> gone = {};
+  long hertz = 100;
+};
+
+#endif
@@ -0,0 +1,35 @@
+#ifndef SNAPSHOT_SOURCE_H
+#define SNAPSHOT_SOURCE_H
+
+#include <string_view>
+#include <vector>
+
+#include "process_filter.h"
+#include "system_snapshot.h"
+
+/*
+Where the display gets its snapshots from: the live sampler or a replay
+All calls come from the display thread.
+*/
+class SnapshotSource {
+ public:
+  virtual ~SnapshotSource() = default;
+  virtual void Start() = 0;
+  virtual void Stop() = 0;
+  // Adopt the newest snapshot, if any; returns true when Latest() changed
+  virtual bool Update() = 0;
+  virtual const SystemSnapshot& Latest() const = 0;
+  // Keys the display does not use itself; returns true when handled
+  virtual bool HandleKey(int) { return false; }
+  // PIDs on screen, which a live source keeps as fresh as busy ones
+  virtual void Prioritize(const std::vector<int>&) {}
+  // Show only the processes filter accepts; false when the source
+  // cannot filter
+  virtual bool FilterBy(const ProcessFilter&) { return false; }
+  // Text of the filter in effect, empty for none
+  virtual std::string_view Filter() const { return {}; }
+  // Short text for the display's title bar, empty for none
+  virtual std::string_view Status() const { return {}; }
+};
+
+#endif
@@ -0,0 +1,49 @@
+#ifndef STRING_POOL_H
+#define STRING_POOL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+/*
+Deduplicated, reference counted store of command lines
+Thousands of workers often share one command line; each distinct text
+is kept once, for as long as some process holds it. Entries never move,
+so a text stays valid until its last Release, and ids are reused, so
+the pool only grows with the number of distinct texts alive at once.
+Interning and releasing are thread-safe.
+*/
+class StringPool {
+ public:
+  using Id = uint32_t;
+  static constexpr Id kNone = UINT32_MAX;
+  struct Entry {
+    Id id{kNone};
+    std::string_view text{};
+  };
+
+  // Take a reference on text, storing it if it is new
+  Entry Intern(std::string_view text);
+  // Drop a reference taken by Intern; kNone is ignored
+  void Release(Id id);
+  std::size_t Size() const;  // distinct texts held
+  Id Limit() const;          // every id handed out is below this
+
+ private:
+  struct Stored {
+    std::string text;
+    uint32_t references;
+  };
+
+  mutable std::mutex mutex = {};
+  std::deque<Stored> entries = {};
+  std::vector<Id> unused = {};
+  std::unordered_map<std::string_view, Id> index = {};
+};
+
+#endif
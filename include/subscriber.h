@@ -0,0 +1,60 @@
+#ifndef SUBSCRIBER_H
+#define SUBSCRIBER_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "process_table.h"
+#include "publication.h"
+#include "snapshot_codec.h"
+#include "snapshot_source.h"
+#include "system_snapshot.h"
+
+/*
+Shows the snapshots a Publisher puts into shared memory
+The segment is mapped read-only and the newest slot is decoded straight
+out of the mapping; a decode the publisher overwrote halfway is thrown
+away and tried again. Nothing under /proc is read. When the publisher
+exits, the last snapshot stays on screen until a new one takes over the
+name.
+*/
+class Subscriber : public SnapshotSource {
+ public:
+  // Throws std::runtime_error when /name is missing or not a publication
+  explicit Subscriber(const std::string& name);
+  ~Subscriber();
+  Subscriber(const Subscriber&) = delete;
+  Subscriber& operator=(const Subscriber&) = delete;
+
+  void Start() override;
+  void Stop() override;
+  bool Update() override;
+  const SystemSnapshot& Latest() const override;
+  std::string_view Status() const override;
+
+ private:
+  // Map /name; false when it is not there or not a usable publication
+  bool Map();
+  void Unmap();
+  bool Read();
+  // Look for a new publisher once the old one is gone; true when the
+  // status changed
+  bool Check();
+
+  const std::string name;
+  const Publication::Header* header{nullptr};
+  std::size_t length{0};
+  uint64_t seen{0};  // Header::latest of the snapshot shown
+  SnapshotDecoder decoder{};
+  ProcessTableBuilder tables{};
+  SystemSnapshot snapshot{};
+  SystemSnapshot incoming{};
+  std::chrono::steady_clock::time_point checked{};
+  bool alive{true};
+  std::string status{};
+};
+
+#endif
@@ -1,16 +1,56 @@
 #ifndef SYSTEM_H
 #define SYSTEM_H
 
+#include <memory>
 #include <string>
+#include <string_view>
+#include <unordered_map>
 #include <vector>
 
+#include "cgroup_stats.h"
+#include "cpu_accounting.h"
+#include "linux_parser.h"
+#include "proc_events.h"
 #include "process.h"
+#include "process_filter.h"
+#include "process_snapshot.h"
+#include "process_table.h"
 #include "processor.h"
+#include "refresh_schedule.h"
+#include "scan_pool.h"
+#include "string_pool.h"
+#include "system_snapshot.h"
+#include "top_processes.h"
 
+/*
+Sampling core of the monitor
+Refresh reads /proc into the current snapshot, each field as often as
+its RefreshSchedule asks; the getters below report from that snapshot
+until it is handed over with Swap
+*/
 class System {
  public:
+  // track_events follows forks and exits through the proc connector
+  // instead of listing /proc every tick, when the kernel allows it
+  explicit System(int threads = 1, bool track_events = false,
+                  RefreshSchedule::Settings schedule = {1, {}});
+  bool TracksEvents() const;
+  // PIDs on screen, kept as fresh as busy processes from the next tick
+  void Prioritize(const std::vector<int>& pids);
+  // Leave the processes the filter rejects out of the snapshots, reading
+  // no more of them than it takes to reject them
+  void FilterBy(ProcessFilter filter);
+  void Refresh();
+  // Exchange the current snapshot with another buffer, whose storage is
+  // reused by the next Refresh
+  void Swap(SystemSnapshot& other);
+  const SystemSnapshot& Current() const;
+
   Processor& Cpu();
-  std::vector<Process>& Processes();
+  // The n first processes in the current sort order
+  std::vector<Process>& Processes(std::size_t n);
+  void SortBy(SortKey key);
+  SortKey Sorting() const;
   float MemoryUtilization();
   long UpTime();
   int TotalProcesses();
@@ -19,8 +59,45 @@ class System {
   std::string OperatingSystem();
 
  private:
+  // Text shared by many processes, copied into the snapshot's arena
+  // once per tick
+  struct Stored {
+    unsigned long tick{0};
+    std::string_view text{};
+  };
+
+  // What the parse phase made of each PID
+  enum Outcome : char { kGone, kShown, kRejected };
+
+  void UpdatePids();
+  // Read the due fields of the i-th PID file by file, cheapest first,
+  // checking the filter after each; fields turns into those read
+  Outcome ReadFiltered(std::size_t i, unsigned& fields, long uptime,
+                       ProcessSnapshot& snapshot);
+  std::string_view StoreCommand(StringPool::Entry command);
+  std::string_view StoreUser(int uid);
+
   Processor cpu = {};
-  std::vector<Process> processes = {};
+  LinuxParser::StatSample stat = {};
+  ScanPool pool;
+  CpuAccounting accounting = {};
+  std::vector<int> pids = {};
+  std::vector<char> outcomes = {};  // Outcome by PID
+  std::vector<char> deferred = {};
+  ProcessFilter filter = {};
+  std::unique_ptr<ProcEvents> events = {};
+  std::vector<int> stale = {};
+  RefreshSchedule schedule;
+  ProcessTableBuilder tables = {};
+  CgroupStats cgroup_stats = {};
+  std::vector<Stored> commands = {};  // by StringPool::Id
+  std::unordered_map<int, Stored> users = {};
+  SystemSnapshot current = {};
+  TopProcesses top = {};
+  unsigned long tick = 0;
+  // Facts that cannot change while the monitor runs, read once
+  const std::string operating_system;
+  const std::string kernel;
 };
 
-#endif
\ No newline at end of file
+#endif
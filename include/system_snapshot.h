@@ -0,0 +1,40 @@
+#ifndef SYSTEM_SNAPSHOT_H
+#define SYSTEM_SNAPSHOT_H
+
+#include <string>
+#include <vector>
+
+#include "arena.h"
+#include "cgroup_snapshot.h"
+#include "memory_snapshot.h"
+#include "process_snapshot.h"
+#include "process_table.h"
+
+/*
+Everything one tick of sampling produced
+It is filled by System::Refresh and then only read, so it can be handed
+to another thread as a whole. The processes' text lives in its arena,
+which moves along with it and is reset when the buffer is refilled.
+*/
+struct SystemSnapshot {
+  unsigned long tick{0};
+  long timestamp_ms{0};  // wall clock, milliseconds since the epoch
+  std::string operating_system{};
+  std::string kernel{};
+  float cpu_utilization{0};
+  std::vector<float> core_utilization{};  // one entry per online core
+  float memory_utilization{0};
+  MemorySnapshot memory{};
+  long uptime{0};
+  int total_processes{0};
+  int running_processes{0};
+  // Ticks between reads of idle processes; above 1 while sampling runs
+  // over its CPU budget
+  unsigned refresh_period{1};
+  std::vector<ProcessSnapshot> processes{};
+  Arena strings{};  // user names and command lines of processes
+  ProcessTable table{};  // the processes again, column by column
+  std::vector<CgroupSnapshot> cgroups{};  // the ones processes run in
+};
+
+#endif
@@ -0,0 +1,39 @@
+#ifndef TOP_PROCESSES_H
+#define TOP_PROCESSES_H
+
+#include <cstddef>
+#include <vector>
+
+#include "process.h"
+#include "system_snapshot.h"
+
+// Columns the process list can be ordered by, largest first (PID: smallest)
+enum class SortKey { kCpu, kRss, kVsz, kTime, kPid };
+
+/*
+Picks the first n processes of a snapshot in the chosen order
+Only those n are sorted; the rest is partitioned away in linear time
+*/
+class TopProcesses {
+ public:
+  std::vector<Process>& Select(const SystemSnapshot& snapshot, std::size_t n);
+  void SortBy(SortKey key);
+  SortKey Sorting() const;
+
+ private:
+  // One numeric key per process, so ordering never chases pointers
+  struct Ranked {
+    double key;
+    int pid;
+    std::size_t index;
+    bool operator<(const Ranked& other) const {
+      return key != other.key ? key > other.key : pid < other.pid;
+    }
+  };
+
+  SortKey sort_key = SortKey::kCpu;
+  std::vector<Ranked> ranked = {};
+  std::vector<Process> processes = {};
+};
+
+#endif
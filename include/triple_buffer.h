@@ -0,0 +1,43 @@
+#ifndef TRIPLE_BUFFER_H
+#define TRIPLE_BUFFER_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+/*
+Lock-free handoff of whole values from one writer to one reader
+The writer fills Back() and publishes it; the reader picks up the most
+recent publication with Update() and reads Front(). Neither side ever
+waits for the other and every buffer is reused, so its storage is too.
+*/
+template <typename T>
+class TripleBuffer {
+ public:
+  // Writer side
+  T& Back() { return buffers[back]; }
+  void Publish() {
+    uint8_t previous = middle.exchange(back | kFresh, std::memory_order_acq_rel);
+    back = previous & kIndex;
+  }
+
+  // Reader side; returns true when a newer value became the front
+  bool Update() {
+    if ((middle.load(std::memory_order_relaxed) & kFresh) == 0) return false;
+    uint8_t previous = middle.exchange(front, std::memory_order_acq_rel);
+    front = previous & kIndex;
+    return true;
+  }
+  const T& Front() const { return buffers[front]; }
+
+ private:
+  static constexpr uint8_t kIndex = 0x3;
+  static constexpr uint8_t kFresh = 0x4;
+
+  std::array<T, 3> buffers = {};
+  std::atomic<uint8_t> middle{1};
+  uint8_t back = 0;
+  uint8_t front = 2;
+};
+
+#endif
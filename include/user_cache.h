@@ -0,0 +1,40 @@
+#ifndef USER_CACHE_H
+#define USER_CACHE_H
+
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include <string>
+#include <unordered_map>
+
+/*
+Process-wide uid -> user name map, and the reverse for filters
+It is built from /etc/passwd once and rebuilt only when the file is
+replaced or modified; uids missing from the file are resolved through
+getpwuid_r and getpwnam_r once each, so NSS (LDAP, sssd...) users show
+up as well
+*/
+class UserCache {
+ public:
+  static UserCache& Instance();
+  // Rebuild the map if /etc/passwd changed since the last load
+  void Refresh();
+  const std::string& Name(int uid);
+  // The uid named name, -1 when there is none
+  int Uid(const std::string& name);
+
+ private:
+  UserCache() = default;
+  void Load();
+  bool Changed(const struct stat& info) const;
+
+  std::unordered_map<int, std::string> names = {};
+  std::unordered_map<std::string, int> uids = {};  // -1 for unknown names
+  bool loaded = false;
+  dev_t device = 0;
+  ino_t inode = 0;
+  off_t size = 0;
+  struct timespec modified = {};
+};
+
+#endif
@@ -0,0 +1,21 @@
+#include <cstdlib>
+#include <new>
+
+#include "instrumentation.h"
+
+// Replaces the global allocator of the monitor so Instrumentation can
+// count allocations; costs one relaxed load while it is disabled.
+// Executables that define their own operator new keep theirs.
+
+void* operator new(std::size_t size) {
+  Instrumentation::Add(Instrumentation::Counter::kAllocations);
+  if (void* memory = std::malloc(size == 0 ? 1 : size)) return memory;
+  throw std::bad_alloc();
+}
+void* operator new[](std::size_t size) { return operator new(size); }
+void operator delete(void* memory) noexcept { std::free(memory); }
+void operator delete[](void* memory) noexcept { std::free(memory); }
+void operator delete(void* memory, std::size_t) noexcept { std::free(memory); }
+void operator delete[](void* memory, std::size_t) noexcept {
+  std::free(memory);
+}
@@ -0,0 +1,47 @@
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <string_view>
+
+#include "arena.h"
+
+// Fits the command lines of a few hundred typical processes
+#define BLOCK_SIZE (64 << 10)
+
+using std::size_t;
+using std::string_view;
+
+string_view Arena::Copy(string_view text) {
+  if (text.empty()) return {};
+  // A block too full for this text is left as it is for this tick
+  while (current < blocks.size() &&
+         offset + text.size() > blocks[current].size) {
+    ++current;
+    offset = 0;
+  }
+  if (current == blocks.size()) {
+    const size_t size = std::max<size_t>(BLOCK_SIZE, text.size());
+    blocks.push_back({std::make_unique<char[]>(size), size});
+    offset = 0;
+  }
+  char* destination = blocks[current].data.get() + offset;
+  std::memcpy(destination, text.data(), text.size());
+  offset += text.size();
+  used += text.size();
+  return string_view(destination, text.size());
+}
+
+void Arena::Reset() {
+  current = 0;
+  offset = 0;
+  used = 0;
+}
+
+size_t Arena::Capacity() const {
+  size_t capacity = 0;
+  for (const Block& block : blocks) capacity += block.size;
+  return capacity;
+}
+
+size_t Arena::Used() const { return used; }
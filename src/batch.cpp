@@ -0,0 +1,161 @@
+#include <unistd.h>
+#include <chrono>
+#include <thread>
+
+#include "batch.h"
+
+#define PERCENT 100
+
+void Batch::WriteCsv(const SystemSnapshot& snapshot, bool header,
+                     OutputBuffer& output) {
+  if (header) {
+    output.Append(
+        "tick,timestamp_ms,pid,uid,user,cpu_percent,rss_kb,vsz_kb,"
+        "shared_kb,uptime_s,command\n");
+  }
+  for (const ProcessSnapshot& process : snapshot.processes) {
+    output.Append(snapshot.tick);
+    output.Append(',');
+    output.Append(snapshot.timestamp_ms);
+    output.Append(',');
+    output.Append(process.pid);
+    output.Append(',');
+    output.Append(process.uid);
+    output.Append(',');
+    output.AppendCsv(process.user);
+    output.Append(',');
+    output.Append(process.cpu_utilization * PERCENT, 2);
+    output.Append(',');
+    output.Append(process.rss);
+    output.Append(',');
+    output.Append(process.vsz);
+    output.Append(',');
+    output.Append(process.shared);
+    output.Append(',');
+    output.Append(process.uptime);
+    output.Append(',');
+    output.AppendCsv(process.command);
+    output.Append('\n');
+  }
+}
+
+void Batch::WriteJson(const SystemSnapshot& snapshot, OutputBuffer& output) {
+  output.Append("{\"tick\":");
+  output.Append(snapshot.tick);
+  output.Append(",\"timestamp_ms\":");
+  output.Append(snapshot.timestamp_ms);
+  output.Append(",\"cpu_percent\":");
+  output.Append(snapshot.cpu_utilization * PERCENT, 2);
+  output.Append(",\"core_percent\":[");
+  for (size_t i = 0; i < snapshot.core_utilization.size(); ++i) {
+    if (i > 0) output.Append(',');
+    output.Append(snapshot.core_utilization[i] * PERCENT, 1);
+  }
+  output.Append(']');
+  output.Append(",\"memory_percent\":");
+  output.Append(snapshot.memory_utilization * PERCENT, 2);
+  const MemorySnapshot& memory = snapshot.memory;
+  output.Append(",\"memory_kb\":{\"total\":");
+  output.Append(memory.total);
+  output.Append(",\"available\":");
+  output.Append(memory.available);
+  output.Append(",\"free\":");
+  output.Append(memory.free);
+  output.Append(",\"buffers\":");
+  output.Append(memory.buffers);
+  output.Append(",\"cached\":");
+  output.Append(memory.cached);
+  output.Append(",\"shared\":");
+  output.Append(memory.shared);
+  output.Append(",\"swap_total\":");
+  output.Append(memory.swap_total);
+  output.Append(",\"swap_free\":");
+  output.Append(memory.swap_free);
+  output.Append(",\"huge_total\":");
+  output.Append(memory.huge_total);
+  output.Append(",\"huge_free\":");
+  output.Append(memory.huge_free);
+  output.Append('}');
+  output.Append(",\"uptime_s\":");
+  output.Append(snapshot.uptime);
+  output.Append(",\"total_processes\":");
+  output.Append(snapshot.total_processes);
+  output.Append(",\"running_processes\":");
+  output.Append(snapshot.running_processes);
+  output.Append(",\"processes\":[");
+  bool first = true;
+  for (const ProcessSnapshot& process : snapshot.processes) {
+    if (!first) output.Append(',');
+    first = false;
+    output.Append("{\"pid\":");
+    output.Append(process.pid);
+    output.Append(",\"uid\":");
+    output.Append(process.uid);
+    output.Append(",\"user\":");
+    output.AppendJson(process.user);
+    output.Append(",\"cpu_percent\":");
+    output.Append(process.cpu_utilization * PERCENT, 2);
+    output.Append(",\"rss_kb\":");
+    output.Append(process.rss);
+    output.Append(",\"vsz_kb\":");
+    output.Append(process.vsz);
+    output.Append(",\"shared_kb\":");
+    output.Append(process.shared);
+    output.Append(",\"uptime_s\":");
+    output.Append(process.uptime);
+    output.Append(",\"command\":");
+    output.AppendJson(process.command);
+    output.Append('}');
+  }
+  output.Append("],\"cgroups\":[");
+  first = true;
+  for (const CgroupSnapshot& cgroup : snapshot.cgroups) {
+    if (!first) output.Append(',');
+    first = false;
+    output.Append("{\"path\":");
+    output.AppendJson(cgroup.path);
+    output.Append(",\"processes\":");
+    output.Append(cgroup.processes);
+    output.Append(",\"cpu_percent\":");
+    output.Append(cgroup.cpu * PERCENT, 2);
+    output.Append(",\"throttled_percent\":");
+    output.Append(cgroup.throttled * PERCENT, 2);
+    output.Append(",\"memory_kb\":");
+    output.Append(cgroup.memory);
+    output.Append(",\"anon_kb\":");
+    output.Append(cgroup.anon);
+    output.Append(",\"file_kb\":");
+    output.Append(cgroup.file);
+    output.Append(",\"read_bps\":");
+    output.Append(cgroup.read_rate, 0);
+    output.Append(",\"write_bps\":");
+    output.Append(cgroup.write_rate, 0);
+    output.Append('}');
+  }
+  output.Append("]}\n");
+}
+
+// Ticks follow absolute deadlines so the interval does not drift by the
+// time spent sampling and writing
+int Batch::Run(Sampler& sampler, const Options& options) {
+  OutputBuffer output(STDOUT_FILENO);
+  auto deadline = std::chrono::steady_clock::now();
+
+  for (long iteration = 0;
+       options.iterations == 0 || iteration < options.iterations;
+       ++iteration) {
+    if (iteration > 0) {
+      deadline += options.sample_interval;
+      std::this_thread::sleep_until(deadline);
+    }
+    sampler.Step();
+    if (options.format == OutputFormat::kJson) {
+      WriteJson(sampler.Latest(), output);
+    } else {
+      WriteCsv(sampler.Latest(), iteration == 0, output);
+    }
+    // One write per tick keeps consumers like log shippers up to date
+    if (!output.Flush()) return 1;
+  }
+  return 0;
+}
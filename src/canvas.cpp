@@ -0,0 +1,78 @@
+#include <curses.h>
+#include <algorithm>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "canvas.h"
+
+// Never a valid cell, marks cells whose content curses has to be told
+#define UNKNOWN_CELL static_cast<chtype>(-1)
+
+Canvas::Canvas(WINDOW* input_window)
+    : window(input_window),
+      rows(getmaxy(input_window)),
+      columns(getmaxx(input_window)),
+      cells(rows * columns, UNKNOWN_CELL) {
+  box(window, 0, 0);
+}
+
+void Canvas::Print(int row, int column, std::string_view text, int width,
+                   attr_t attributes) {
+  if (row <= 0 || row >= rows - 1) return;
+  const int length = std::max<int>(width, text.size());
+  const int last = std::min(column + length, columns - 1);
+
+  for (int x = std::max(column, 1); x < last; ++x) {
+    const size_t index = x - column;
+    const char character = index < text.size() ? text[index] : ' ';
+    const chtype cell = static_cast<unsigned char>(character) | attributes;
+    chtype& previous = cells[row * columns + x];
+    if (previous != cell) {
+      previous = cell;
+      mvwaddch(window, row, x, cell);
+    }
+  }
+}
+
+void Canvas::Title(std::string_view text) {
+  if (text == title) return;
+  title.assign(text);
+  mvwhline(window, 0, 1, ACS_HLINE, columns - 2);
+  mvwaddnstr(window, 0, 2, title.data(),
+             std::max(0, std::min<int>(title.size(), columns - 4)));
+}
+
+void Canvas::Resize(int new_rows, int new_columns) {
+  wresize(window, new_rows, new_columns);
+
+  std::vector<chtype> resized(new_rows * new_columns, UNKNOWN_CELL);
+  // Cells inside both the old and the new border keep their content;
+  // the rest, including the old border, is blanked until text arrives
+  const int kept_rows = std::min(rows, new_rows) - 1;
+  const int kept_columns = std::min(columns, new_columns) - 1;
+  for (int y = 1; y < new_rows - 1; ++y) {
+    for (int x = 1; x < new_columns - 1; ++x) {
+      chtype& cell = resized[y * new_columns + x];
+      if (y < kept_rows && x < kept_columns) {
+        cell = cells[y * columns + x];
+      } else {
+        cell = ' ';
+        mvwaddch(window, y, x, ' ');
+      }
+    }
+  }
+
+  rows = new_rows;
+  columns = new_columns;
+  cells.swap(resized);
+  box(window, 0, 0);
+  const std::string previous = std::move(title);
+  title.clear();
+  Title(previous);
+}
+
+WINDOW* Canvas::Window() const { return window; }
+
+int Canvas::Columns() const { return columns; }
@@ -0,0 +1,218 @@
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "cgroup_stats.h"
+#include "linux_parser.h"
+#include "proc_reader.h"
+
+using std::size_t;
+using std::string;
+using std::string_view;
+using std::vector;
+
+namespace {
+// One reader per thread, like LinuxParser's
+ProcReader& Reader() {
+  thread_local ProcReader reader;
+  return reader;
+}
+
+bool ReadFile(const string& directory, const char* name,
+              string_view& content) {
+  thread_local string path;
+  path.assign(directory).append(name);
+  return Reader().Read(path, content);
+}
+
+// Number following "key " at the start of a line (cpu.stat, memory.stat)
+bool Field(string_view content, string_view key, uint64_t& value) {
+  while (!content.empty()) {
+    string_view line = ProcParse::Line(content);
+    if (line.size() > key.size() && line[key.size()] == ' ' &&
+        line.compare(0, key.size(), key) == 0) {
+      line.remove_prefix(key.size() + 1);
+      return ProcParse::Number(line, value);
+    }
+  }
+  return false;
+}
+
+// Sum of "key=N" over the device lines of io.stat
+uint64_t DeviceSum(string_view content, string_view key) {
+  uint64_t sum = 0;
+  while (!content.empty()) {
+    const string_view line = ProcParse::Line(content);
+    const size_t at = line.find(key);
+    if (at == string_view::npos) continue;
+    string_view value = line.substr(at + key.size());
+    uint64_t number = 0;
+    if (ProcParse::Number(value, number)) sum += number;
+  }
+  return sum;
+}
+
+// Counters restart when a cgroup is removed and created again
+double Rate(uint64_t before, uint64_t after, double seconds) {
+  return after > before ? (after - before) / seconds : 0;
+}
+}  // namespace
+
+CgroupStats::CgroupStats()
+    : available(access((LinuxParser::CgroupDirectory() + "cgroup.controllers")
+                           .c_str(),
+                       R_OK) == 0) {}
+
+bool CgroupStats::Available() const { return available; }
+
+uint32_t CgroupStats::Intern(const string& path) {
+  auto found = ids.find(path);
+  if (found != ids.end()) return found->second;
+  uint32_t id;
+  if (unused.empty()) {
+    id = static_cast<uint32_t>(cgroups.size());
+    cgroups.emplace_back();
+  } else {
+    id = unused.back();
+    unused.pop_back();
+  }
+  Cgroup& cgroup = cgroups[id];
+  cgroup.path.assign(path);
+  cgroup.directory.assign(LinuxParser::CgroupDirectory());
+  if (path != "/") cgroup.directory.append(path, 1).push_back('/');
+  cgroup.tick = 0;
+  cgroup.read = false;
+  cgroup.snapshot = CgroupSnapshot();
+  cgroup.snapshot.path.assign(path);
+  ids.emplace(path, id);
+  return id;
+}
+
+// Missing files read as zero: the root cgroup has no memory.current, and
+// controllers that are not enabled leave theirs out
+void CgroupStats::Read(Cgroup& cgroup,
+                       std::chrono::steady_clock::time_point now) {
+  Counters counters;
+  CgroupSnapshot& snapshot = cgroup.snapshot;
+  string_view content;
+  uint64_t value = 0;
+  if (ReadFile(cgroup.directory, "cpu.stat", content)) {
+    Field(content, "usage_usec", counters.usage_usec);
+    Field(content, "throttled_usec", counters.throttled_usec);
+  }
+  snapshot.memory = 0;
+  if (ReadFile(cgroup.directory, "memory.current", content) &&
+      ProcParse::Number(content, value)) {
+    snapshot.memory = static_cast<long>(value / 1024);
+  }
+  snapshot.anon = snapshot.file = 0;
+  if (ReadFile(cgroup.directory, "memory.stat", content)) {
+    if (Field(content, "anon", value)) {
+      snapshot.anon = static_cast<long>(value / 1024);
+    }
+    if (Field(content, "file", value)) {
+      snapshot.file = static_cast<long>(value / 1024);
+    }
+  }
+  if (ReadFile(cgroup.directory, "io.stat", content)) {
+    counters.read_bytes = DeviceSum(content, " rbytes=");
+    counters.write_bytes = DeviceSum(content, " wbytes=");
+  }
+
+  const double seconds =
+      std::chrono::duration<double>(now - cgroup.time).count();
+  if (cgroup.read && seconds > 0) {
+    const Counters& before = cgroup.counters;
+    snapshot.cpu = static_cast<float>(
+        Rate(before.usage_usec, counters.usage_usec, seconds) / 1e6);
+    snapshot.throttled = static_cast<float>(
+        Rate(before.throttled_usec, counters.throttled_usec, seconds) / 1e6);
+    snapshot.read_rate = Rate(before.read_bytes, counters.read_bytes, seconds);
+    snapshot.write_rate =
+        Rate(before.write_bytes, counters.write_bytes, seconds);
+  }
+  cgroup.counters = counters;
+  cgroup.time = now;
+  cgroup.read = true;
+}
+
+// Processes known from the last tick keep their cgroup, matched by PID and
+// start time in one merge of the two sorted lists; only new ones have
+// their /proc/<pid>/cgroup read
+void CgroupStats::Refresh(const vector<ProcessSnapshot>& processes,
+                          ScanPool& pool, vector<CgroupSnapshot>& output) {
+  if (!available) {
+    output.clear();
+    return;
+  }
+  ++tick;
+  const auto now = std::chrono::steady_clock::now();
+
+  spare.clear();
+  unknown.clear();
+  size_t known = 0;
+  for (const ProcessSnapshot& process : processes) {
+    while (known < members.size() && members[known].pid < process.pid) {
+      ++known;
+    }
+    if (known < members.size() && members[known].pid == process.pid &&
+        members[known].starttime == process.starttime) {
+      spare.push_back(members[known]);
+    } else {
+      unknown.push_back(spare.size());
+      spare.push_back({process.pid, process.starttime, kNone});
+    }
+  }
+  std::swap(members, spare);
+
+  if (paths.size() < unknown.size()) paths.resize(unknown.size());
+  pool.ForEach(unknown.size(), [this](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      LinuxParser::ReadCgroup(members[unknown[i]].pid, paths[i]);
+    }
+  });
+  for (size_t i = 0; i < unknown.size(); ++i) {
+    if (!paths[i].empty()) members[unknown[i]].cgroup = Intern(paths[i]);
+  }
+
+  used.clear();
+  for (const Member& member : members) {
+    if (member.cgroup == kNone) continue;
+    Cgroup& cgroup = cgroups[member.cgroup];
+    if (cgroup.tick != tick) {
+      cgroup.tick = tick;
+      cgroup.processes = 0;
+      used.push_back(member.cgroup);
+    }
+    ++cgroup.processes;
+  }
+  // Cgroups left without processes are forgotten, and start over if any
+  // come back
+  for (auto id = ids.begin(); id != ids.end();) {
+    if (cgroups[id->second].tick == tick) {
+      ++id;
+    } else {
+      unused.push_back(id->second);
+      id = ids.erase(id);
+    }
+  }
+
+  pool.ForEach(used.size(), [this, now](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) Read(cgroups[used[i]], now);
+  });
+  std::sort(used.begin(), used.end(), [this](uint32_t a, uint32_t b) {
+    return cgroups[a].path < cgroups[b].path;
+  });
+  output.resize(used.size());
+  for (size_t i = 0; i < used.size(); ++i) {
+    const Cgroup& cgroup = cgroups[used[i]];
+    output[i] = cgroup.snapshot;
+    output[i].processes = cgroup.processes;
+  }
+}
@@ -0,0 +1,54 @@
+#include <unistd.h>
+#include <chrono>
+
+#include "cpu_accounting.h"
+
+void CpuAccounting::Begin(std::chrono::steady_clock::time_point now) {
+  last = now;
+  ++tick;
+}
+
+void CpuAccounting::Update(ProcessSnapshot& snapshot) {
+  static const long hertz = sysconf(_SC_CLK_TCK);
+  const long jiffies = snapshot.utime + snapshot.stime;
+
+  auto found = index.find(snapshot.pid);
+  if (found == index.end()) {
+    entries.push_front(
+        {snapshot.pid, snapshot.starttime, jiffies, tick, last});
+    index.emplace(snapshot.pid, entries.begin());
+    return;
+  }
+
+  Entry& entry = *found->second;
+  // Same PID and start time: the same process as last time. Processes
+  // the schedule skipped for a few ticks get the average over the gap.
+  const double elapsed =
+      std::chrono::duration<double>(last - entry.time).count();
+  if (entry.starttime == snapshot.starttime && elapsed > 0 &&
+      jiffies >= entry.jiffies) {
+    snapshot.cpu_utilization =
+        static_cast<float>((jiffies - entry.jiffies) / (hertz * elapsed));
+  }
+  entry.starttime = snapshot.starttime;
+  entry.jiffies = jiffies;
+  entry.tick = tick;
+  entry.time = last;
+  entries.splice(entries.begin(), entries, found->second);
+}
+
+void CpuAccounting::Keep(const ProcessSnapshot& snapshot) {
+  auto found = index.find(snapshot.pid);
+  if (found == index.end()) return;
+  found->second->tick = tick;
+  entries.splice(entries.begin(), entries, found->second);
+}
+
+void CpuAccounting::Sweep() {
+  while (!entries.empty() && entries.back().tick != tick) {
+    index.erase(entries.back().pid);
+    entries.pop_back();
+  }
+}
+
+std::size_t CpuAccounting::Size() const { return entries.size(); }
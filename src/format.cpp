@@ -1,4 +1,7 @@
+#include <algorithm>
+#include <cstdio>
 #include <string>
+#include <string_view>
 
 #include "format.h"
 
@@ -10,14 +13,19 @@ using std::string;
 // INPUT: Long int measuring seconds
 // OUTPUT: HH:MM:SS
 string Format::ElapsedTime(long seconds) {
-  int hour(seconds/HOUR);
-  int minutes((seconds/MINUTE)%MINUTE);
-  int second(seconds%MINUTE);
-  string string_hour, string_minute, string_seconds;
+  char buffer[32];
+  return string(ElapsedTime(seconds, buffer, sizeof(buffer)));
+}
 
-  string_hour = hour < 10 ? "0" + std::to_string(hour) : std::to_string(hour);
-  string_minute = minutes < 10 ? "0" + std::to_string(minutes) : std::to_string(minutes);
-  string_seconds = second < 10 ? "0" + std::to_string(second) : std::to_string(second);
+std::string_view Format::ElapsedTime(long seconds, char* buffer,
+                                     std::size_t size) {
+  long hour(seconds / HOUR);
+  int minutes((seconds / MINUTE) % MINUTE);
+  int second(seconds % MINUTE);
 
-  return string_hour + ":" + string_minute + ":" + string_seconds;
-}
\ No newline at end of file
+  int length = std::snprintf(buffer, size, "%02ld:%02d:%02d", hour, minutes,
+                             second);
+  if (length < 0) return std::string_view();
+  return std::string_view(buffer,
+                          std::min<std::size_t>(length, size ? size - 1 : 0));
+}
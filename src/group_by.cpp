@@ -0,0 +1,110 @@
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "group_by.h"
+#include "instrumentation.h"
+
+using std::size_t;
+using std::vector;
+
+namespace {
+// sums[keys[i]] += values[i] over the whole column
+template <typename Value, typename Sum>
+void Accumulate(const vector<uint32_t>& keys, const vector<Value>& values,
+                vector<Sum>& sums) {
+  const uint32_t* key = keys.data();
+  const Value* value = values.data();
+  Sum* sum = sums.data();
+  const size_t size = keys.size();
+  for (size_t i = 0; i < size; ++i) sum[key[i]] += value[i];
+}
+
+// Larger values sort first
+double SortValue(const Group& group, SortKey key) {
+  switch (key) {
+    case SortKey::kCpu:
+      return group.cpu;
+    case SortKey::kRss:
+      return group.rss;
+    case SortKey::kVsz:
+      return group.vsz;
+    case SortKey::kTime:
+    case SortKey::kPid:
+      return group.count;
+  }
+  return 0;
+}
+}  // namespace
+
+GroupKey NextGroupKey(GroupKey key) {
+  switch (key) {
+    case GroupKey::kNone:
+      return GroupKey::kUser;
+    case GroupKey::kUser:
+      return GroupKey::kCommand;
+    case GroupKey::kCommand:
+      return GroupKey::kParent;
+    case GroupKey::kParent:
+      return GroupKey::kNone;
+  }
+  return GroupKey::kNone;
+}
+
+const vector<Group>& GroupBy::Select(const ProcessTable& table, GroupKey key,
+                                     SortKey sorting, size_t n) {
+  Instrumentation::ScopedTimer timer(Instrumentation::Phase::kSort);
+  const size_t size = table.Size();
+  size_t buckets = 0;
+  switch (key) {
+    case GroupKey::kUser:
+      keys.assign(table.user.begin(), table.user.end());
+      buckets = table.users.size();
+      break;
+    case GroupKey::kCommand:
+      keys.assign(table.command.begin(), table.command.end());
+      buckets = table.commands.size();
+      break;
+    case GroupKey::kParent:
+      // Orphans share the bucket after the last row
+      keys.resize(size);
+      for (size_t i = 0; i < size; ++i) {
+        keys[i] = table.parent[i] == ProcessTable::kNoParent
+                      ? static_cast<uint32_t>(size)
+                      : table.parent[i];
+      }
+      buckets = size + 1;
+      break;
+    case GroupKey::kNone:
+      groups.clear();
+      return groups;
+  }
+
+  counts.assign(buckets, 0);
+  cpu.assign(buckets, 0);
+  rss.assign(buckets, 0);
+  vsz.assign(buckets, 0);
+  for (uint32_t bucket : keys) ++counts[bucket];
+  Accumulate(keys, table.cpu, cpu);
+  Accumulate(keys, table.rss, rss);
+  Accumulate(keys, table.vsz, vsz);
+
+  groups.clear();
+  for (size_t i = 0; i < buckets; ++i) {
+    if (counts[i] == 0) continue;
+    groups.push_back(
+        {static_cast<uint32_t>(i), counts[i], cpu[i], rss[i], vsz[i]});
+  }
+  auto before = [sorting](const Group& first, const Group& second) {
+    const double a = SortValue(first, sorting), b = SortValue(second, sorting);
+    return a != b ? a > b : first.key < second.key;
+  };
+  n = std::min(n, groups.size());
+  if (n < groups.size()) {
+    std::nth_element(groups.begin(), groups.begin() + n, groups.end(), before);
+  }
+  std::sort(groups.begin(), groups.begin() + n, before);
+  groups.resize(n);
+  return groups;
+}
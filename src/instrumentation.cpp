@@ -0,0 +1,159 @@
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+
+#include "instrumentation.h"
+
+// Four buckets per power of two of nanoseconds, up to 2^64
+#define SUB_BUCKETS 4
+#define BUCKETS 256
+
+namespace Instrumentation {
+std::atomic<bool> enabled{false};
+}  // namespace Instrumentation
+
+using Instrumentation::Counter;
+using Instrumentation::Phase;
+
+namespace {
+struct Histogram {
+  std::array<std::atomic<uint64_t>, BUCKETS> buckets{};
+  std::atomic<uint64_t> count{0};
+  std::atomic<uint64_t> total{0};
+  std::atomic<uint64_t> max{0};
+};
+
+std::array<Histogram, static_cast<size_t>(Phase::kCount)> histograms;
+std::array<std::atomic<uint64_t>, static_cast<size_t>(Counter::kCount)>
+    counters{};
+
+size_t Bucket(uint64_t nanoseconds) {
+  if (nanoseconds < SUB_BUCKETS) return nanoseconds;
+  const int power = 63 - __builtin_clzll(nanoseconds);
+  return (power - 1) * SUB_BUCKETS + ((nanoseconds >> (power - 2)) & 3);
+}
+
+// Largest value that falls into bucket
+uint64_t Upper(size_t bucket) {
+  if (bucket < SUB_BUCKETS) return bucket;
+  const int power = bucket / SUB_BUCKETS + 1;
+  const uint64_t sub = bucket % SUB_BUCKETS;
+  return ((SUB_BUCKETS + sub + 1) << (power - 2)) - 1;
+}
+
+double Percentile(const Histogram& histogram, uint64_t count,
+                  double fraction) {
+  const uint64_t rank = std::max<uint64_t>(1, fraction * count + 0.5);
+  uint64_t seen = 0;
+  for (size_t i = 0; i < BUCKETS; ++i) {
+    seen += histogram.buckets[i].load(std::memory_order_relaxed);
+    if (seen >= rank) {
+      // Never report more than was actually measured
+      return std::min(Upper(i), histogram.max.load()) / 1e3;
+    }
+  }
+  return histogram.max.load() / 1e3;
+}
+}  // namespace
+
+void Instrumentation::Enable() { enabled = true; }
+
+void Instrumentation::Disable() { enabled = false; }
+
+void Instrumentation::Record(Phase phase, std::chrono::nanoseconds elapsed) {
+  Histogram& histogram = histograms[static_cast<size_t>(phase)];
+  const uint64_t nanoseconds = std::max<int64_t>(elapsed.count(), 0);
+  histogram.buckets[Bucket(nanoseconds)].fetch_add(1,
+                                                   std::memory_order_relaxed);
+  histogram.count.fetch_add(1, std::memory_order_relaxed);
+  histogram.total.fetch_add(nanoseconds, std::memory_order_relaxed);
+  uint64_t max = histogram.max.load(std::memory_order_relaxed);
+  while (nanoseconds > max &&
+         !histogram.max.compare_exchange_weak(max, nanoseconds,
+                                              std::memory_order_relaxed)) {
+  }
+}
+
+void Instrumentation::AddSlow(Counter counter, uint64_t amount) {
+  counters[static_cast<size_t>(counter)].fetch_add(amount,
+                                                   std::memory_order_relaxed);
+}
+
+Instrumentation::Summary Instrumentation::Summarize(Phase phase) {
+  const Histogram& histogram = histograms[static_cast<size_t>(phase)];
+  Summary summary;
+  summary.count = histogram.count.load(std::memory_order_relaxed);
+  if (summary.count == 0) return summary;
+  summary.total_ms = histogram.total.load(std::memory_order_relaxed) / 1e6;
+  summary.p50_us = Percentile(histogram, summary.count, 0.5);
+  summary.p99_us = Percentile(histogram, summary.count, 0.99);
+  summary.max_us = histogram.max.load(std::memory_order_relaxed) / 1e3;
+  return summary;
+}
+
+uint64_t Instrumentation::Total(Counter counter) {
+  return counters[static_cast<size_t>(counter)].load(
+      std::memory_order_relaxed);
+}
+
+const char* Instrumentation::Name(Phase phase) {
+  switch (phase) {
+    case Phase::kRefresh:
+      return "refresh";
+    case Phase::kPidScan:
+      return "pid scan";
+    case Phase::kParse:
+      return "parse";
+    case Phase::kAccounting:
+      return "accounting";
+    case Phase::kUsers:
+      return "users";
+    case Phase::kCgroups:
+      return "cgroups";
+    case Phase::kSort:
+      return "sort";
+    case Phase::kRender:
+      return "render";
+    default:
+      return "?";
+  }
+}
+
+const char* Instrumentation::Name(Counter counter) {
+  switch (counter) {
+    case Counter::kFilesOpened:
+      return "files opened";
+    case Counter::kBytesRead:
+      return "bytes read";
+    case Counter::kAllocations:
+      return "allocations";
+    case Counter::kDeferred:
+      return "deferred";
+    default:
+      return "?";
+  }
+}
+
+void Instrumentation::Dump(std::FILE* stream) {
+  std::fprintf(stream, "%-12s %10s %12s %10s %10s %10s\n", "phase", "count",
+               "total_ms", "p50_us", "p99_us", "max_us");
+  for (size_t i = 0; i < static_cast<size_t>(Phase::kCount); ++i) {
+    const Phase phase = static_cast<Phase>(i);
+    const Summary summary = Summarize(phase);
+    std::fprintf(stream, "%-12s %10lu %12.3f %10.1f %10.1f %10.1f\n",
+                 Name(phase), static_cast<unsigned long>(summary.count),
+                 summary.total_ms, summary.p50_us, summary.p99_us,
+                 summary.max_us);
+  }
+  const uint64_t ticks = std::max<uint64_t>(1, Summarize(Phase::kRefresh).count);
+  std::fprintf(stream, "%-12s %10s %12s\n", "counter", "per tick", "total");
+  for (size_t i = 0; i < static_cast<size_t>(Counter::kCount); ++i) {
+    const Counter counter = static_cast<Counter>(i);
+    std::fprintf(stream, "%-12s %10.1f %12lu\n", Name(counter),
+                 static_cast<double>(Total(counter)) / ticks,
+                 static_cast<unsigned long>(Total(counter)));
+  }
+}
@@ -1,25 +1,82 @@
 #include <dirent.h>
 #include <unistd.h>
+#include <algorithm>
+#include <charconv>
+#include <cstring>
 #include <sstream>
 #include <string>
+#include <string_view>
+#include <utility>
 #include <vector>
 
 #include "linux_parser.h"
+#include "proc_reader.h"
+#include "user_cache.h"
 
-#define SAMESTRING 0
 #define NO_UPTIME 0
 
-using std::stof;
 using std::string;
+using std::string_view;
 using std::to_string;
 using std::vector;
 
+namespace {
+// One reader per thread, reused for every file it parses
+ProcReader& Reader() {
+  thread_local ProcReader reader;
+  return reader;
+}
+
+// Full paths derived from the roots, built once instead of per read
+struct Roots {
+  string proc{LinuxParser::kProcDirectory};
+  string os_release{LinuxParser::kOSPath};
+  string password{LinuxParser::kPasswordPath};
+  string cgroup{LinuxParser::kCgroupDirectory};
+};
+
+Roots& CurrentRoots() {
+  static Roots roots;
+  return roots;
+}
+
+string Directory(const string& path) {
+  return !path.empty() && path.back() == '/' ? path : path + '/';
+}
+
+// cmdline separates arguments with NUL bytes; show them space separated
+void AssignCommand(string_view content, string& command) {
+  while (!content.empty() && content.back() == '\0') {
+    content.remove_suffix(1);
+  }
+  command.assign(content);
+  std::replace(command.begin(), command.end(), '\0', ' ');
+}
+}  // namespace
+
+void LinuxParser::SetRoots(const string& proc, const string& etc,
+                           const string& cgroup) {
+  Roots& roots = CurrentRoots();
+  roots.proc = Directory(proc);
+  roots.os_release = Directory(etc) + kOSReleaseFilename;
+  roots.password = Directory(etc) + kPasswordFilename;
+  roots.cgroup = Directory(cgroup);
+}
+
+const string& LinuxParser::ProcDirectory() { return CurrentRoots().proc; }
+
+const string& LinuxParser::CgroupDirectory() { return CurrentRoots().cgroup; }
+
+const string& LinuxParser::OSPath() { return CurrentRoots().os_release; }
+
+const string& LinuxParser::PasswordPath() { return CurrentRoots().password; }
+
 string LinuxParser::OperatingSystem() {
   string line;
   string key;
   string value;
 
-  std::ifstream filestream(kOSPath);
+  std::ifstream filestream(OSPath());
 
   if (filestream.is_open()) {
     while (std::getline(filestream, line)) {
@@ -43,7 +100,7 @@ string LinuxParser::Kernel() {
   string os, kernel, version;
   string line;
 
-  std::ifstream stream(kProcDirectory + kVersionFilename);
+  std::ifstream stream(ProcDirectory() + kVersionFilename);
 
   if (stream.is_open()) {
     std::getline(stream, line);
@@ -55,108 +112,164 @@ string LinuxParser::Kernel() {
 
 vector<int> LinuxParser::Pids() {
   vector<int> pids;
-  DIR* directory = opendir(kProcDirectory.c_str());
+  DIR* directory = opendir(ProcDirectory().c_str());
+  if (directory == nullptr) return pids;
 
   struct dirent* file;
 
   while ((file = readdir(directory)) != nullptr) {
     if (file->d_type == DT_DIR) {
-      string filename(file->d_name);
-      if (std::all_of(filename.begin(), filename.end(), isdigit)) {
-        int pid = stoi(filename);
+      const char* first = file->d_name;
+      const char* last = first + strlen(first);
+      int pid = 0;
+      auto result = std::from_chars(first, last, pid);
+      if (result.ec == std::errc() && result.ptr == last) {
         pids.push_back(pid);
       }
     }
   }
   closedir(directory);
+  // /proc lists PIDs in ascending order, other trees may not
+  if (!std::is_sorted(pids.begin(), pids.end())) {
+    std::sort(pids.begin(), pids.end());
+  }
   return pids;
 }
 
 float LinuxParser::MemoryUtilization() {
-  string line, key_name, total, free;
-  float total_memory, free_memory;
-  std::istringstream currentline;
+  MemorySnapshot memory;
+  Memory(memory);
+  return MemoryUtilization(memory);
+}
 
-  std::ifstream stream(kProcDirectory + kMeminfoFilename);
+float LinuxParser::MemoryUtilization(const MemorySnapshot& memory) {
+  if (memory.total == 0) return 0;
+  return std::clamp(
+      1 - static_cast<float>(memory.available) / memory.total, 0.0f, 1.0f);
+}
 
-  if (stream.is_open()){
-    while(std::getline(stream, line)){
-      std::replace(line.begin(), line.end(), ':', ' ');
-      currentline.str(line);
-      currentline >> key_name;
-      if (key_name.compare(TOTAL_MEMORY) == SAMESTRING){
-        currentline >> total;
-        total_memory = stof(total);
-      } else if (key_name.compare(FREE_MEMORY) == SAMESTRING) {
-        currentline >> free;
-        free_memory = stof(free);
-      } else {
-        currentline.clear();
-      }
+// One pass over the file; keys it lacks read as 0
+bool LinuxParser::Memory(MemorySnapshot& memory) {
+  memory = MemorySnapshot();
+  string_view content;
+  if (!Reader().ReadProc(kMeminfoFilename, content)) return false;
+
+  long available = -1, reclaimable = 0, huge_pages = 0, huge_free = 0,
+       huge_size = 0;
+  const std::pair<string_view, long*> keys[] = {
+      {TOTAL_MEMORY, &memory.total},  {AVAILABLE_MEMORY, &available},
+      {FREE_MEMORY, &memory.free},    {"Buffers", &memory.buffers},
+      {"Cached", &memory.cached},     {"SReclaimable", &reclaimable},
+      {"Shmem", &memory.shared},      {"SwapTotal", &memory.swap_total},
+      {"SwapFree", &memory.swap_free}, {"HugePages_Total", &huge_pages},
+      {"HugePages_Free", &huge_free}, {"Hugepagesize", &huge_size}};
+  while (!content.empty()) {
+    string_view line = ProcParse::Line(content);
+    const size_t colon = line.find(':');
+    if (colon == string_view::npos) continue;
+    const string_view key = line.substr(0, colon);
+    for (const auto& [name, value] : keys) {
+      if (key != name) continue;
+      line.remove_prefix(colon + 1);
+      ProcParse::Number(line, *value);
+      break;
     }
   }
-  return (1 - free_memory/total_memory);
+  // Kernels before 3.14 have no MemAvailable; estimate it as free(1) did
+  memory.available =
+      available >= 0 ? available
+                     : memory.free + memory.buffers + memory.cached;
+  memory.cached += reclaimable;
+  memory.huge_total = huge_pages * huge_size;
+  memory.huge_free = huge_free * huge_size;
+  return true;
 }
 
 long LinuxParser::UpTime() {
-  string line, uptime;
-  std::istringstream currentline;
+  string_view content;
+  long uptime = NO_UPTIME;
 
-  std::ifstream stream(kProcDirectory + kUptimeFilename);
-
-  if (stream.is_open()) {
-    std::getline(stream, line);
-    currentline.str(line);
-    currentline >> uptime;
+  if (Reader().ReadProc(kUptimeFilename, content)) {
+    ProcParse::Number(content, uptime);
   }
-
-  return uptime.empty() ? NO_UPTIME : stol(uptime);
+  return uptime;
 }
 
-long LinuxParser::Jiffies() { 
-  return LinuxParser::ActiveJiffies() + LinuxParser::IdleJiffies();
-}
+long LinuxParser::Jiffies() { return Stat().cpu.Total(); }
 
 long LinuxParser::ActiveJiffies(int pid) {
-  string line, value;
-  vector<string> values;
-  long utime = 0, stime = 0;
-  std::istringstream currentline;
+  string_view content;
+  PidStat stat;
 
-  std::ifstream stream(kProcDirectory + std::to_string(pid) + kStatFilename);
+  if (!Reader().Read(pid, kStatFilename, content) ||
+      !ProcParse::Stat(content, stat)) {
+    return 0;
+  }
+  return stat.utime + stat.stime;
+}
 
-  if (stream.is_open()) {
-    std::getline(stream, line);
-    currentline.str(line);
+long LinuxParser::ActiveJiffies() { return Stat().cpu.Active(); }
 
-    while (currentline >> value) {
-      values.push_back(value);
-    }
-    currentline.clear();
-  }
+long LinuxParser::IdleJiffies() { return Stat().cpu.Idle(); }
 
-  if (std::all_of(values[13].begin(), values[13].end(), isdigit)) {
-    utime = stol(values[13]);
-  }
-  if (std::all_of(values[14].begin(), values[14].end(), isdigit)) {
-    stime = stol(values[14]);
-  }
+unsigned long long LinuxParser::CpuTimes::Active() const {
+  return jiffies[kUser_] + jiffies[kNice_] + jiffies[kSystem_] +
+         jiffies[kIRQ_] + jiffies[kSoftIRQ_] + jiffies[kSteal_];
+}
 
-  return utime+stime;
+unsigned long long LinuxParser::CpuTimes::Idle() const {
+  return jiffies[kIdle_] + jiffies[kIOwait_];
 }
 
-long LinuxParser::ActiveJiffies() {
-  auto jiffies = CpuUtilization();
+unsigned long long LinuxParser::CpuTimes::Total() const {
+  return Active() + Idle();
+}
 
-  return stol(jiffies[CPUStates::kUser_]) + stol(jiffies[CPUStates::kNice_]) +
-         stol(jiffies[CPUStates::kSystem_]) + stol(jiffies[CPUStates::kIRQ_]) +
-         stol(jiffies[CPUStates::kSoftIRQ_]) +
-         stol(jiffies[CPUStates::kSteal_]);
+LinuxParser::StatSample LinuxParser::Stat() {
+  StatSample sample;
+  Stat(sample);
+  return sample;
 }
 
-long LinuxParser::IdleJiffies() {
-  auto jiffies = CpuUtilization();
-  return stol(jiffies[CPUStates::kIdle_]) + stol(jiffies[CPUStates::kIOwait_]);
+// Read /proc/stat once and pick out the cpu lines and counters
+bool LinuxParser::Stat(StatSample& sample) {
+  string_view content;
+  sample.cores.busy.clear();
+  sample.cores.total.clear();
+
+  if (!Reader().ReadProc(kStatFilename, content)) {
+    sample = StatSample();
+    return false;
+  }
+  while (!content.empty()) {
+    string_view line = ProcParse::Line(content);
+    string_view key_name = line.substr(0, line.find(' '));
+    line.remove_prefix(key_name.size());
+
+    if (key_name == CPU) {
+      for (auto& value : sample.cpu.jiffies) {
+        if (!ProcParse::Number(line, value)) break;
+      }
+    } else if (key_name.compare(0, CPU.size(), CPU) == 0) {
+      // "cpuN"; offline cores have no line, so cores are numbered densely
+      CpuTimes core;
+      for (auto& value : core.jiffies) {
+        if (!ProcParse::Number(line, value)) break;
+      }
+      sample.cores.busy.push_back(core.Active());
+      sample.cores.total.push_back(core.Total());
+    } else if (key_name == INTERRUPTS) {
+      ProcParse::Number(line, sample.interrupts);
+    } else if (key_name == CONTEXT_SWITCHES) {
+      ProcParse::Number(line, sample.context_switches);
+    } else if (key_name == PROCESS) {
+      ProcParse::Number(line, sample.processes);
+    } else if (key_name == PROCESS_RUNNING) {
+      ProcParse::Number(line, sample.procs_running);
+      break;
+    }
+  }
+  return true;
 }
 
 vector<string> LinuxParser::CpuUtilization() {
@@ -164,7 +277,7 @@ vector<string> LinuxParser::CpuUtilization() {
   vector<string> jiffies;
   std::istringstream currentline;
 
-  std::ifstream stream(kProcDirectory + kStatFilename);
+  std::ifstream stream(ProcDirectory() + kStatFilename);
 
   if (stream.is_open()){
     std::getline(stream, line);
@@ -179,147 +292,148 @@ vector<string> LinuxParser::CpuUtilization() {
   return jiffies;
 }
 
-int LinuxParser::TotalProcesses() {
-  string line, key_name;
-  int process = 0;
-  std::istringstream currentline;
+int LinuxParser::TotalProcesses() { return Stat().processes; }
 
-  std::ifstream stream(kProcDirectory + kStatFilename);
+int LinuxParser::RunningProcesses() { return Stat().procs_running; }
 
-  if (stream.is_open()){
-    while (std::getline(stream, line)) {
-      currentline.str(line);
-      currentline >> key_name;
-      if (key_name.compare(PROCESS) == SAMESTRING) {
-        currentline >> process;
-        break;
-      } else {
-        currentline.clear();
-      }
-    }
-  }
-  return process;
+string LinuxParser::Command(int pid) {
+  string cmdline;
+  ReadCommand(pid, cmdline);
+  return cmdline;
 }
 
-int LinuxParser::RunningProcesses() {
-  string line, key_name;
-  int process = 0;
-  std::istringstream currentline;
+bool LinuxParser::ReadCommand(int pid, string& command) {
+  string_view content;
+
+  command.clear();
+  if (!Reader().Read(pid, kCmdlineFilename, content)) return false;
+  AssignCommand(content, command);
+  return true;
+}
 
-  std::ifstream stream(kProcDirectory + kStatFilename);
+bool LinuxParser::ReadCgroup(int pid, string& path) {
+  string_view content;
 
-  if (stream.is_open()) {
-    while (std::getline(stream, line)) {
-      currentline.str(line);
-      currentline >> key_name;
-      if (key_name.compare(PROCESS_RUNNING) == SAMESTRING) {
-        currentline >> process;
-        break;
-      } else {
-        currentline.clear();
-      }
+  path.clear();
+  if (!Reader().Read(pid, kCgroupFilename, content)) return false;
+  while (!content.empty()) {
+    const string_view line = ProcParse::Line(content);
+    if (line.compare(0, 3, "0::") == 0) {
+      path.assign(line.substr(3));
+      return !path.empty();
     }
   }
-  return process;
+  return false;
 }
 
-string LinuxParser::Command(int pid) {
-  string cmdline;
-
-  std::ifstream stream(kProcDirectory + std::to_string(pid) + kCmdlineFilename);
+string LinuxParser::Ram(int pid) {
+  string_view content;
+  PidStatm statm;
 
-  if (stream.is_open()) {
-    std::getline(stream, cmdline);
+  if (Reader().Read(pid, kStatmFilename, content)) {
+    ProcParse::Statm(content, statm);
   }
-
-  return cmdline.empty() ? EMPTY : cmdline;
+  return std::to_string(statm.resident * (sysconf(_SC_PAGESIZE) / 1024));
 }
 
-string LinuxParser::Ram(int pid) {
-  string line, key_name;
-  long virtual_memory_size = 0;
-  std::istringstream currentline;
+string LinuxParser::Uid(int pid) {
+  string_view content;
+  int uid = 0;
 
-  std::ifstream stream(kProcDirectory + std::to_string(pid) + kStatusFilename);
-
-  if(stream.is_open()){
-    while(std::getline(stream, line)){
-      std::replace(line.begin(), line.end(), ':', ' ');
-      currentline.str(line);
-      currentline >> key_name;
-      if (key_name.compare(VMSIZE) == SAMESTRING) {
-        currentline >> virtual_memory_size;
-      } else {
-        currentline.clear();
-      }
-    }
+  if (Reader().Read(pid, kStatusFilename, content) &&
+      ProcParse::KeyValue(content, UID, uid)) {
+    return std::to_string(uid);
   }
+  return EMPTY;
+}
 
-  return std::to_string(virtual_memory_size);
+string LinuxParser::User(int pid) {
+  string uid = Uid(pid);
+  return uid.empty() ? EMPTY : UserName(stoi(uid));
 }
 
-string LinuxParser::Uid(int pid) {
-  string line, key_name, uid;
-  std::istringstream currentline;
+string LinuxParser::UserName(int uid) {
+  return UserCache::Instance().Name(uid);
+}
 
-  std::ifstream stream(kProcDirectory + std::to_string(pid) + kStatusFilename);
+long LinuxParser::UpTime(int pid) {
+  string_view content;
+  PidStat stat;
 
-  if (stream.is_open()) {
-    while (std::getline(stream, line)) {
-      std::replace(line.begin(), line.end(), ':', ' ');
-      currentline.str(line);
-      currentline >> key_name;
-      if (key_name.compare(UID) == SAMESTRING) {
-        currentline >> uid;
-        break;
-      } else {
-        currentline.clear();
-      }
-    }
+  if (!Reader().Read(pid, kStatFilename, content) ||
+      !ProcParse::Stat(content, stat)) {
+    return 0;
   }
-  return uid.empty() ? EMPTY : uid;
+  return stat.starttime / sysconf(_SC_CLK_TCK);
 }
 
-string LinuxParser::User(int pid) {
-  string line, username, passwd, uid, line_uid, user;
-  std::istringstream currentline;
-  uid = Uid(pid);
+// Fill a snapshot from one read of each of stat, statm, status, cmdline
+// and smaps_rollup, skipping the files whose fields were not asked for.
+// Returns false when the process vanished while being read.
+// Reuses the snapshot's strings, so a steady state scan does not allocate.
+// The user name is left to the caller; this runs on scan threads.
+bool LinuxParser::ReadProcess(int pid, long uptime, ProcessSnapshot& snapshot,
+                              unsigned fields) {
+  ProcReader& reader = Reader();
+  string_view content;
+  snapshot.pid = pid;
+
+  if (fields & kStatFields) {
+    PidStat stat;
+    if (!reader.Read(pid, kStatFilename, content) ||
+        !ProcParse::Stat(content, stat)) {
+      return false;
+    }
+    snapshot.name.assign(stat.comm);
+    snapshot.state = stat.state;
+    snapshot.ppid = stat.ppid;
+    snapshot.utime = stat.utime;
+    snapshot.stime = stat.stime;
+    snapshot.starttime = stat.starttime;
+
+    static const long hertz = sysconf(_SC_CLK_TCK);
+    const long start_second = snapshot.starttime / hertz;
+    snapshot.uptime = uptime > start_second ? uptime - start_second : 0;
+    snapshot.cpu_utilization =
+        snapshot.uptime > 0
+            ? static_cast<float>(snapshot.utime + snapshot.stime) / hertz /
+                  snapshot.uptime
+            : 0;
+  }
 
-  std::ifstream stream(kPasswordPath);
+  if (fields & kMemoryFields) {
+    PidStatm statm;
+    if (reader.Read(pid, kStatmFilename, content)) {
+      ProcParse::Statm(content, statm);
+    }
+    static const long page_kilobytes = sysconf(_SC_PAGESIZE) / 1024;
+    snapshot.vsz = statm.size * page_kilobytes;
+    snapshot.rss = statm.resident * page_kilobytes;
+    snapshot.shared = statm.shared * page_kilobytes;
+  }
 
-  if (stream.is_open()) {
-    while (std::getline(stream, line)) {
-      std::replace(line.begin(), line.end(), ':', ' ');
-      currentline.str(line);
-
-      currentline >> username >> passwd >> line_uid;
-      if (line_uid == uid) {
-        user = username;
-        break;
-      } else {
-        currentline.clear();
-      }
+  if (fields & kSmapsFields) {
+    // Needs the same access as ptrace; other users' processes stay at -1
+    PidSmaps smaps;
+    snapshot.pss = snapshot.uss = -1;
+    if (reader.Read(pid, kSmapsRollupFilename, content) &&
+        ProcParse::Smaps(content, smaps)) {
+      snapshot.pss = smaps.pss;
+      snapshot.uss = smaps.private_clean + smaps.private_dirty;
     }
   }
-  return user.empty() ? EMPTY : user;
-}
 
-long LinuxParser::UpTime(int pid) {
-  string line, value;
-  vector<string> values;
-  long start_time = 0;
-  std::ifstream stream(kProcDirectory + std::to_string(pid) + kStatFilename);
-  if (stream.is_open()) {
-    std::getline(stream, line);
-    std::istringstream currentline(line);
-    while (currentline >> value) {
-      values.push_back(value);
+  if (fields & kStatusFields) {
+    snapshot.uid = -1;
+    if (reader.Read(pid, kStatusFilename, content)) {
+      ProcParse::KeyValue(content, UID, snapshot.uid);
     }
   }
-  try {
-    start_time = stol(values[21]) / sysconf(_SC_CLK_TCK);
-    return start_time;
-  } catch (...) {
-    return start_time;
+
+  if (fields & kCommandFields) {
+    thread_local string command;
+    ReadCommand(pid, command);
+    snapshot.command = command;
   }
+  return true;
 }
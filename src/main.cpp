@@ -1,7 +1,126 @@
+#include <pthread.h>
+#include <signal.h>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+
+#include "batch.h"
+#include "instrumentation.h"
+#include "linux_parser.h"
+#include "metrics_server.h"
 #include "ncurses_display.h"
+#include "options.h"
+#include "process_filter.h"
+#include "publisher.h"
+#include "recorder.h"
+#include "refresh_schedule.h"
+#include "replayer.h"
+#include "sampler.h"
+#include "subscriber.h"
 #include "system.h"
 
-int main() {
-  System system;
-  NCursesDisplay::Display(system);
-}
\ No newline at end of file
+namespace {
+// Sample in the background until SIGINT or SIGTERM, which the caller
+// blocked before any thread was started
+int Serve(Sampler& sampler, const sigset_t& signals) {
+  sampler.Start();
+  int signal = 0;
+  sigwait(&signals, &signal);
+  sampler.Stop();
+  return 0;
+}
+
+// Live monitoring, in the UI, in batch mode, for attached viewers or for
+// scrapers; returns the exit status
+int Sample(const Options& options) {
+  // Threads inherit the mask, so only sigwait sees these signals
+  sigset_t signals;
+  sigemptyset(&signals);
+  sigaddset(&signals, SIGINT);
+  sigaddset(&signals, SIGTERM);
+  const bool headless = options.publish || !options.listen.empty();
+  if (headless) pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+  std::unique_ptr<Recorder> recorder;
+  std::unique_ptr<Publisher> publisher;
+  std::unique_ptr<MetricsServer> server;
+  const RefreshSchedule::Settings schedule{
+      static_cast<unsigned>(options.memory_interval),
+      std::chrono::duration_cast<std::chrono::microseconds>(
+          options.sample_interval * options.budget) /
+          100};
+  System system(options.threads, options.events, schedule);
+  if (options.events && !system.TracksEvents()) {
+    std::cerr << "process events unavailable, scanning /proc instead\n";
+  }
+  Sampler sampler(system, options.sample_interval);
+  sampler.FilterBy(ProcessFilter(options.filter));
+  if (!options.record.empty()) {
+    recorder = std::make_unique<Recorder>(options.record, options.record_size);
+    sampler.AddListener([&recorder](const SystemSnapshot& snapshot) {
+      recorder->Append(snapshot);
+    });
+  }
+  if (options.publish) {
+    publisher =
+        std::make_unique<Publisher>(options.shm_name, options.shm_size);
+    sampler.AddListener([&publisher](const SystemSnapshot& snapshot) {
+      publisher->Publish(snapshot);
+    });
+  }
+  if (!options.listen.empty()) {
+    server =
+        std::make_unique<MetricsServer>(options.listen, options.metrics_top);
+    sampler.AddListener([&server](const SystemSnapshot& snapshot) {
+      server->Publish(snapshot);
+    });
+    server->Start();
+  }
+  if (headless) {
+    const int status = Serve(sampler, signals);
+    if (server) server->Stop();
+    return status;
+  }
+  if (options.batch) {
+    return Batch::Run(sampler, options);
+  }
+  NCursesDisplay::Display(sampler, options.render_interval);
+  return 0;
+}
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  Options options;
+  try {
+    options = ParseOptions(argc, argv);
+  } catch (const std::invalid_argument& error) {
+    std::cerr << error.what() << "\n" << Usage(argv[0]);
+    return 1;
+  }
+  if (options.help) {
+    std::cout << Usage(argv[0]);
+    return 0;
+  }
+
+  LinuxParser::SetRoots(options.proc_root, options.etc_root,
+                        options.cgroup_root);
+  if (options.instrument) Instrumentation::Enable();
+  int status = 0;
+  try {
+    if (!options.replay.empty()) {
+      Replayer replayer(options.replay);
+      NCursesDisplay::Display(replayer, options.render_interval);
+    } else if (options.attach) {
+      Subscriber subscriber(options.shm_name);
+      NCursesDisplay::Display(subscriber, options.render_interval);
+    } else {
+      status = Sample(options);
+    }
+  } catch (const std::runtime_error& error) {
+    std::cerr << error.what() << "\n";
+    return 1;
+  }
+  if (options.instrument) Instrumentation::Dump(stderr);
+  return status;
+}
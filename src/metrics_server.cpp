@@ -0,0 +1,259 @@
+#include <netdb.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "metrics_server.h"
+
+// Scrapers served at once; more wait in the listen backlog
+#define MAX_CONNECTIONS 64
+// Longest request head accepted
+#define MAX_REQUEST 8192
+// Connections that send or take nothing for this long are dropped
+#define IDLE_TIMEOUT std::chrono::seconds(10)
+#define POLL_INTERVAL_MS 1000
+
+using std::string;
+using std::string_view;
+
+namespace {
+string Plain(string_view status, string_view body) {
+  string response("HTTP/1.1 ");
+  response.append(status)
+      .append("\r\nContent-Type: text/plain; charset=utf-8\r\n"
+              "Content-Length: ")
+      .append(std::to_string(body.size()))
+      .append("\r\nConnection: close\r\n\r\n")
+      .append(body);
+  return response;
+}
+}  // namespace
+
+MetricsServer::MetricsServer(const string& address, std::size_t top)
+    : text(top),
+      unavailable(Plain("503 Service Unavailable", "no sample yet\n")),
+      not_found(Plain("404 Not Found", "only /metrics is served\n")),
+      not_allowed(Plain("405 Method Not Allowed", "only GET is served\n")) {
+  const size_t colon = address.rfind(':');
+  if (colon == string::npos) {
+    throw std::runtime_error("no port in " + address);
+  }
+  string host = address.substr(0, colon);
+  const string port = address.substr(colon + 1);
+  if (host.size() >= 2 && host.front() == '[' && host.back() == ']') {
+    host = host.substr(1, host.size() - 2);
+  }
+
+  addrinfo hints{};
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  hints.ai_flags = AI_PASSIVE | AI_NUMERICSERV;
+  addrinfo* addresses = nullptr;
+  const int resolved = getaddrinfo(host.empty() ? nullptr : host.c_str(),
+                                   port.c_str(), &hints, &addresses);
+  if (resolved != 0) {
+    throw std::runtime_error("cannot resolve " + address + ": " +
+                             gai_strerror(resolved));
+  }
+  int error = 0;
+  for (addrinfo* entry = addresses; entry && listener < 0;
+       entry = entry->ai_next) {
+    listener = socket(entry->ai_family,
+                      entry->ai_socktype | SOCK_NONBLOCK | SOCK_CLOEXEC,
+                      entry->ai_protocol);
+    if (listener < 0) {
+      error = errno;
+      continue;
+    }
+    const int on = 1;
+    setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    if (bind(listener, entry->ai_addr, entry->ai_addrlen) != 0 ||
+        listen(listener, SOMAXCONN) != 0) {
+      error = errno;
+      close(listener);
+      listener = -1;
+    }
+  }
+  freeaddrinfo(addresses);
+  if (listener < 0) {
+    throw std::runtime_error("cannot listen on " + address + ": " +
+                             std::strerror(error));
+  }
+  wake = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+  if (wake < 0) {
+    close(listener);
+    throw std::runtime_error(string("cannot create eventfd: ") +
+                             std::strerror(errno));
+  }
+}
+
+MetricsServer::~MetricsServer() {
+  Stop();
+  for (Connection& connection : connections) Close(connection);
+  close(wake);
+  close(listener);
+}
+
+void MetricsServer::Start() { thread = std::thread(&MetricsServer::Run, this); }
+
+void MetricsServer::Stop() {
+  if (!thread.joinable()) return;
+  const uint64_t one = 1;
+  while (write(wake, &one, sizeof(one)) < 0 && errno == EINTR) {
+  }
+  thread.join();
+}
+
+// The response is rendered into a buffer no scrape is reading, found
+// under the mutex: current only changes here and Answer only hands out
+// current, so nothing can start reading it until it is published
+void MetricsServer::Publish(const SystemSnapshot& snapshot) {
+  text.Write(snapshot, body);
+  Buffer* spare = nullptr;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (const auto& buffer : buffers) {
+      if (buffer.get() != current && buffer->readers == 0) {
+        spare = buffer.get();
+        break;
+      }
+    }
+  }
+  if (!spare) {
+    buffers.push_back(std::make_unique<Buffer>());
+    spare = buffers.back().get();
+  }
+  string& response = spare->response;
+  response.assign(
+      "HTTP/1.1 200 OK\r\n"
+      "Content-Type: text/plain; version=0.0.4; charset=utf-8\r\n"
+      "Content-Length: ");
+  response.append(std::to_string(body.size()))
+      .append("\r\nConnection: close\r\n\r\n")
+      .append(body);
+  std::lock_guard<std::mutex> lock(mutex);
+  current = spare;
+}
+
+void MetricsServer::Run() {
+  std::vector<pollfd> descriptors;
+  while (true) {
+    descriptors.clear();
+    descriptors.push_back({wake, POLLIN, 0});
+    const bool full = connections.size() >= MAX_CONNECTIONS;
+    descriptors.push_back({listener, static_cast<short>(full ? 0 : POLLIN), 0});
+    for (const Connection& connection : connections) {
+      descriptors.push_back(
+          {connection.descriptor,
+           static_cast<short>(connection.response ? POLLOUT : POLLIN), 0});
+    }
+    if (poll(descriptors.data(), descriptors.size(), POLL_INTERVAL_MS) < 0 &&
+        errno != EINTR) {
+      return;
+    }
+    if (descriptors[0].revents) return;
+
+    const auto now = std::chrono::steady_clock::now();
+    size_t kept = 0;
+    for (size_t i = 0; i < connections.size(); ++i) {
+      Connection& connection = connections[i];
+      bool keep;
+      if (descriptors[i + 2].revents) {
+        keep = Serve(connection);
+        connection.since = now;
+      } else {
+        keep = now - connection.since < IDLE_TIMEOUT;
+      }
+      if (!keep) {
+        Close(connection);
+      } else if (kept != i) {
+        connections[kept++] = std::move(connection);
+      } else {
+        ++kept;
+      }
+    }
+    connections.resize(kept);
+    if (descriptors[1].revents & POLLIN) Accept();
+  }
+}
+
+void MetricsServer::Accept() {
+  while (connections.size() < MAX_CONNECTIONS) {
+    const int descriptor =
+        accept4(listener, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if (descriptor < 0) {
+      if (errno == EINTR) continue;
+      return;
+    }
+    connections.push_back({descriptor, {}, nullptr, nullptr, 0,
+                           std::chrono::steady_clock::now()});
+  }
+}
+
+void MetricsServer::Close(Connection& connection) {
+  close(connection.descriptor);
+  if (!connection.buffer) return;
+  std::lock_guard<std::mutex> lock(mutex);
+  --connection.buffer->readers;
+}
+
+bool MetricsServer::Serve(Connection& connection) {
+  if (!connection.response) {
+    char buffer[1024];
+    const ssize_t count = read(connection.descriptor, buffer, sizeof(buffer));
+    if (count < 0) return errno == EAGAIN || errno == EINTR;
+    if (count == 0) return false;
+    connection.request.append(buffer, count);
+    if (connection.request.find("\r\n\r\n") == string::npos &&
+        connection.request.find("\n\n") == string::npos) {
+      return connection.request.size() < MAX_REQUEST;
+    }
+    Answer(connection);
+    connection.written = 0;
+  }
+  const string& response = *connection.response;
+  while (connection.written < response.size()) {
+    const ssize_t count =
+        send(connection.descriptor, response.data() + connection.written,
+             response.size() - connection.written, MSG_NOSIGNAL);
+    if (count < 0) return errno == EAGAIN || errno == EINTR;
+    connection.written += count;
+  }
+  return false;
+}
+
+void MetricsServer::Answer(Connection& connection) {
+  const string_view head(connection.request);
+  const size_t method_end = head.find(' ');
+  if (method_end == string_view::npos || head.substr(0, method_end) != "GET") {
+    connection.response = &not_allowed;
+    return;
+  }
+  string_view target = head.substr(method_end + 1);
+  target = target.substr(0, target.find_first_of(" \r\n"));
+  target = target.substr(0, target.find('?'));
+  if (target != "/metrics") {
+    connection.response = &not_found;
+    return;
+  }
+  std::lock_guard<std::mutex> lock(mutex);
+  if (!current) {
+    connection.response = &unavailable;
+    return;
+  }
+  ++current->readers;
+  connection.buffer = current;
+  connection.response = &current->response;
+}
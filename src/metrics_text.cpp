@@ -0,0 +1,222 @@
+#include <algorithm>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "metrics_text.h"
+
+#define KILOBYTE 1024
+// Longest number to_chars produces for the types written here
+#define MAX_NUMBER 64
+
+using std::size_t;
+using std::string;
+using std::string_view;
+
+namespace {
+template <typename T>
+void Number(string& output, T value) {
+  char buffer[MAX_NUMBER];
+  const auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+  output.append(buffer, result.ptr - buffer);
+}
+
+// Label values escape backslashes, quotes and line breaks
+void Quoted(string& output, string_view text) {
+  output.push_back('"');
+  for (char character : text) {
+    if (character == '\\' || character == '"') {
+      output.push_back('\\');
+      output.push_back(character);
+    } else if (character == '\n') {
+      output.append("\\n");
+    } else {
+      output.push_back(character);
+    }
+  }
+  output.push_back('"');
+}
+
+void Family(string& output, string_view name, string_view type,
+            string_view help) {
+  output.append("# HELP ").append(name).push_back(' ');
+  output.append(help).append("\n# TYPE ").append(name).push_back(' ');
+  output.append(type).push_back('\n');
+}
+
+// name{labels} value, labels already formatted without the braces
+template <typename T>
+void Sample(string& output, string_view name, string_view labels, T value) {
+  output.append(name);
+  if (!labels.empty()) output.append("{").append(labels).push_back('}');
+  output.push_back(' ');
+  Number(output, value);
+  output.push_back('\n');
+}
+
+template <typename T>
+void Gauge(string& output, string_view name, string_view help, T value) {
+  Family(output, name, "gauge", help);
+  Sample(output, name, {}, value);
+}
+}  // namespace
+
+MetricsText::MetricsText(size_t n) : top(n) { by_rss.SortBy(SortKey::kRss); }
+
+void MetricsText::Write(const SystemSnapshot& snapshot, string& output) {
+  output.clear();
+  Gauge(output, "monitor_cpu_usage_ratio",
+        "Share of all CPUs busy during the last tick.",
+        snapshot.cpu_utilization);
+  Family(output, "monitor_core_usage_ratio", "gauge",
+         "Share of each core busy during the last tick.");
+  for (size_t i = 0; i < snapshot.core_utilization.size(); ++i) {
+    label.assign("core=\"");
+    Number(label, i);
+    label.push_back('"');
+    Sample(output, "monitor_core_usage_ratio", label,
+           snapshot.core_utilization[i]);
+  }
+
+  const MemorySnapshot& memory = snapshot.memory;
+  Gauge(output, "monitor_memory_usage_ratio",
+        "Share of memory not available without swapping.",
+        snapshot.memory_utilization);
+  Gauge(output, "monitor_memory_total_bytes", "MemTotal.",
+        int64_t{memory.total} * KILOBYTE);
+  Gauge(output, "monitor_memory_available_bytes", "MemAvailable.",
+        int64_t{memory.available} * KILOBYTE);
+  Gauge(output, "monitor_memory_free_bytes", "MemFree.",
+        int64_t{memory.free} * KILOBYTE);
+  Gauge(output, "monitor_memory_buffers_bytes", "Buffers.",
+        int64_t{memory.buffers} * KILOBYTE);
+  Gauge(output, "monitor_memory_cached_bytes",
+        "Page cache and reclaimable slab.",
+        int64_t{memory.cached} * KILOBYTE);
+  Gauge(output, "monitor_memory_shared_bytes", "Shmem.",
+        int64_t{memory.shared} * KILOBYTE);
+  Gauge(output, "monitor_swap_total_bytes", "SwapTotal.",
+        int64_t{memory.swap_total} * KILOBYTE);
+  Gauge(output, "monitor_swap_free_bytes", "SwapFree.",
+        int64_t{memory.swap_free} * KILOBYTE);
+  Gauge(output, "monitor_hugepages_total_bytes",
+        "Memory reserved for huge pages.",
+        int64_t{memory.huge_total} * KILOBYTE);
+  Gauge(output, "monitor_hugepages_free_bytes",
+        "Reserved huge page memory not in use.",
+        int64_t{memory.huge_free} * KILOBYTE);
+
+  Gauge(output, "monitor_uptime_seconds", "Time since boot.", snapshot.uptime);
+  Family(output, "monitor_forks_total", "counter",
+         "Processes and threads created since boot.");
+  Sample(output, "monitor_forks_total", {}, snapshot.total_processes);
+  Gauge(output, "monitor_processes_running",
+        "Threads runnable at the time of the sample.",
+        snapshot.running_processes);
+  Gauge(output, "monitor_processes", "Processes sampled.",
+        snapshot.processes.size());
+  Gauge(output, "monitor_sample_timestamp_seconds",
+        "Wall clock time of the sample.", snapshot.timestamp_ms / 1000.0);
+
+  // One sample per entry of labels/ends, for each family below
+  auto series = [&](string_view name, size_t count, auto value) {
+    size_t begin = 0;
+    for (size_t i = 0; i < count; ++i) {
+      Sample(output, name,
+             string_view(labels).substr(begin, ends[i] - begin), value(i));
+      begin = ends[i];
+    }
+  };
+
+  // Per user totals over every process, bounded by the number of users
+  const ProcessTable& table = snapshot.table;
+  const std::vector<Group>& users = group_by.Select(
+      table, GroupKey::kUser, SortKey::kCpu, table.users.size());
+  labels.clear();
+  ends.clear();
+  for (const Group& group : users) {
+    labels.append("user=");
+    Quoted(labels, table.users[group.key]);
+    ends.push_back(labels.size());
+  }
+  Family(output, "monitor_user_processes", "gauge", "Processes per user.");
+  series("monitor_user_processes", users.size(),
+         [&users](size_t i) { return users[i].count; });
+  Family(output, "monitor_user_cpu_cores", "gauge",
+         "CPUs busy with each user's processes during the last tick.");
+  series("monitor_user_cpu_cores", users.size(),
+         [&users](size_t i) { return users[i].cpu; });
+  Family(output, "monitor_user_resident_bytes", "gauge",
+         "Resident memory of each user's processes, shared pages counted "
+         "once per process.");
+  series("monitor_user_resident_bytes", users.size(),
+         [&users](size_t i) { return users[i].rss * KILOBYTE; });
+
+  const std::vector<CgroupSnapshot>& cgroups = snapshot.cgroups;
+  labels.clear();
+  ends.clear();
+  for (const CgroupSnapshot& cgroup : cgroups) {
+    labels.append("cgroup=");
+    Quoted(labels, cgroup.path);
+    ends.push_back(labels.size());
+  }
+  Family(output, "monitor_cgroup_processes", "gauge",
+         "Processes per cgroup.");
+  series("monitor_cgroup_processes", cgroups.size(),
+         [&cgroups](size_t i) { return cgroups[i].processes; });
+  Family(output, "monitor_cgroup_cpu_cores", "gauge",
+         "CPUs busy with each cgroup during the last tick.");
+  series("monitor_cgroup_cpu_cores", cgroups.size(),
+         [&cgroups](size_t i) { return cgroups[i].cpu; });
+  Family(output, "monitor_cgroup_memory_bytes", "gauge",
+         "memory.current of each cgroup.");
+  series("monitor_cgroup_memory_bytes", cgroups.size(), [&cgroups](size_t i) {
+    return int64_t{cgroups[i].memory} * KILOBYTE;
+  });
+
+  // The busiest and the largest processes, each listed once
+  selected.clear();
+  for (const Process& process : by_cpu.Select(snapshot, top)) {
+    selected.push_back(process);
+  }
+  for (const Process& process : by_rss.Select(snapshot, top)) {
+    selected.push_back(process);
+  }
+  std::sort(selected.begin(), selected.end(),
+            [](const Process& a, const Process& b) {
+              return a.GetPid() < b.GetPid();
+            });
+  selected.erase(std::unique(selected.begin(), selected.end(),
+                             [](const Process& a, const Process& b) {
+                               return a.GetPid() == b.GetPid();
+                             }),
+                 selected.end());
+  labels.clear();
+  ends.clear();
+  for (const Process& process : selected) {
+    labels.append("pid=\"");
+    Number(labels, process.GetPid());
+    labels.append("\",name=");
+    Quoted(labels, process.GetName());
+    labels.append(",user=");
+    Quoted(labels, process.GetUser());
+    ends.push_back(labels.size());
+  }
+  Family(output, "monitor_process_cpu_cores", "gauge",
+         "CPUs busy with the process during the last tick; top processes "
+         "only.");
+  series("monitor_process_cpu_cores", selected.size(), [this](size_t i) {
+    return selected[i].GetCpuUtilization();
+  });
+  Family(output, "monitor_process_resident_bytes", "gauge",
+         "Resident memory of the process; top processes only.");
+  series("monitor_process_resident_bytes", selected.size(), [this](size_t i) {
+    return int64_t{selected[i].GetRss()} * KILOBYTE;
+  });
+  Family(output, "monitor_process_age_seconds", "gauge",
+         "Time since the process started; top processes only.");
+  series("monitor_process_age_seconds", selected.size(),
+         [this](size_t i) { return selected[i].GetUpTime(); });
+}
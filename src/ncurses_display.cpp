@@ -1,113 +1,720 @@
 #include <curses.h>
+#include <algorithm>
 #include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
 #include <string>
-#include <thread>
+#include <string_view>
 #include <vector>
 
+#include "canvas.h"
 #include "format.h"
+#include "group_by.h"
+#include "instrumentation.h"
 #include "ncurses_display.h"
-#include "system.h"
+#include "process_filter.h"
+#include "process_tree.h"
+#include "snapshot_source.h"
+#include "system_snapshot.h"
+#include "top_processes.h"
+
+#define SYSTEM_ROWS 10
+#define CORE_COLUMN 10
+#define OVERLAY_ROWS 14
+#define OVERLAY_COLUMNS 54
+#define WARM_LEVEL 5
+#define HOT_LEVEL 9
 
 using std::string;
-using std::to_string;
+using std::string_view;
+using NCursesDisplay::kLineSize;
+using NCursesDisplay::LineBuffer;
+
+namespace {
+// printf into a fixed line buffer and return the result as a view
+template <typename... Arguments>
+string_view Line(LineBuffer& line, const char* format,
+                 Arguments... arguments) {
+  int length = std::snprintf(line, kLineSize, format, arguments...);
+  if (length < 0) return string_view();
+  return string_view(line, std::min<size_t>(length, kLineSize - 1));
+}
+
+// Mirrors to_string(value).substr(0, width)
+string_view Number(LineBuffer& line, float value, size_t width) {
+  return Line(line, "%f", value).substr(0, width);
+}
+}  // namespace
 
 // 50 bars uniformly displayed from 0 - 100 %
 // 2% is one bar(|)
-std::string NCursesDisplay::ProgressBar(float percent) {
-  std::string result{"0%"};
-  int size{50};
-  float bars{percent * size};
+string_view NCursesDisplay::ProgressBar(float percent, LineBuffer& line) {
+  int const size{50};
+  float const bars{percent * size};
+  LineBuffer number;
 
+  string_view display{Number(number, percent * 100, 4)};
+  const char* prefix{""};
+  if (percent < 0.1 || percent == 1.0) {
+    display = Number(number, percent * 100, 3);
+    prefix = " ";
+  }
+  char bar[size + 1];
   for (int i{0}; i < size; ++i) {
-    result += i <= bars ? '|' : ' ';
+    bar[i] = i <= bars ? '|' : ' ';
   }
-
-  string display{to_string(percent * 100).substr(0, 4)};
-  if (percent < 0.1 || percent == 1.0)
-    display = " " + to_string(percent * 100).substr(0, 3);
-  return result + " " + display + "/100%";
+  bar[size] = '\0';
+  return Line(line, "0%%%s %s%.*s/100%%", bar, prefix,
+              static_cast<int>(display.size()), display.data());
 }
 
-void NCursesDisplay::DisplaySystem(System& system, WINDOW* window) {
+void NCursesDisplay::DisplaySystem(const SystemSnapshot& system,
+                                   Canvas& canvas) {
+  LineBuffer line;
+  int const width{canvas.Columns()};
   int row{0};
-  mvwprintw(window, ++row, 2, ("OS: " + system.OperatingSystem()).c_str());
-  mvwprintw(window, ++row, 2, ("Kernel: " + system.Kernel()).c_str());
-  mvwprintw(window, ++row, 2, "CPU: ");
-  wattron(window, COLOR_PAIR(1));
-  mvwprintw(window, row, 10, "");
-  wprintw(window, ProgressBar(system.Cpu().Utilization()).c_str());
-  wattroff(window, COLOR_PAIR(1));
-  mvwprintw(window, ++row, 2, "Memory: ");
-  wattron(window, COLOR_PAIR(1));
-  mvwprintw(window, row, 10, "");
-  wprintw(window, ProgressBar(system.MemoryUtilization()).c_str());
-  wattroff(window, COLOR_PAIR(1));
-  mvwprintw(window, ++row, 2,
-            ("Total Processes: " + to_string(system.TotalProcesses())).c_str());
-  mvwprintw(
-      window, ++row, 2,
-      ("Running Processes: " + to_string(system.RunningProcesses())).c_str());
-  mvwprintw(window, ++row, 2,
-            ("Up Time: " + Format::ElapsedTime(system.UpTime())).c_str());
-  wrefresh(window);
+  canvas.Print(++row, 2, Line(line, "OS: %s", system.operating_system.c_str()),
+               width);
+  canvas.Print(++row, 2, Line(line, "Kernel: %s", system.kernel.c_str()),
+               width);
+  canvas.Print(++row, 2, "CPU:    ");
+  canvas.Print(row, 10, ProgressBar(system.cpu_utilization, line), width,
+               COLOR_PAIR(1));
+  row = DisplayCores(system.core_utilization, canvas, row + 1);
+  canvas.Print(++row, 2, "Memory: ");
+  canvas.Print(row, 10, ProgressBar(system.memory_utilization, line), width,
+               COLOR_PAIR(1));
+  const MemorySnapshot& memory = system.memory;
+  constexpr float gigabyte = 1024 * 1024;
+  canvas.Print(
+      ++row, 10,
+      Line(line,
+           "used %.1fG  buffers %.1fG  cache %.1fG  available %.1fG  "
+           "swap %.1f/%.1fG  huge %.1f/%.1fG",
+           (memory.total - memory.available) / gigabyte,
+           memory.buffers / gigabyte, memory.cached / gigabyte,
+           memory.available / gigabyte,
+           (memory.swap_total - memory.swap_free) / gigabyte,
+           memory.swap_total / gigabyte,
+           (memory.huge_total - memory.huge_free) / gigabyte,
+           memory.huge_total / gigabyte),
+      width);
+  canvas.Print(++row, 2,
+               Line(line, "Total Processes: %d", system.total_processes),
+               width);
+  canvas.Print(++row, 2,
+               Line(line, "Running Processes: %d", system.running_processes),
+               width);
+  LineBuffer elapsed;
+  string_view uptime{Format::ElapsedTime(system.uptime, elapsed, kLineSize)};
+  canvas.Print(++row, 2,
+               Line(line, "Up Time: %.*s", static_cast<int>(uptime.size()),
+                    uptime.data()),
+               width);
+}
+
+// One cell per core, wrapped over as many rows as CoreRows reserves:
+// the tens digit of its utilization, colored by load. Cells are diffed
+// by the canvas, so only cores whose digit or color changed are drawn.
+int NCursesDisplay::DisplayCores(const std::vector<float>& cores,
+                                 Canvas& canvas, int row) {
+  const int per_row = std::max(1, canvas.Columns() - 1 - CORE_COLUMN);
+  const int rows = CoreRows(cores.size(), canvas.Columns());
+  for (int i = 0; i < rows; ++i) {
+    canvas.Print(row + i, 2, i == 0 ? "Cores:" : "", CORE_COLUMN - 2);
+  }
+  for (size_t i = 0; i < cores.size(); ++i) {
+    const int level = std::clamp(static_cast<int>(cores[i] * 10), 0, 9);
+    const char cell = static_cast<char>('0' + level);
+    const attr_t color =
+        COLOR_PAIR(level >= HOT_LEVEL ? 5 : level >= WARM_LEVEL ? 4 : 3);
+    canvas.Print(row + i / per_row, CORE_COLUMN + i % per_row,
+                 string_view(&cell, 1), 0, color);
+  }
+  // Blank the rest of the last row, e.g. after a core went offline
+  const int used = cores.size() % per_row;
+  if (used > 0) {
+    canvas.Print(row + rows - 1, CORE_COLUMN + used, "", per_row - used);
+  }
+  return row + rows - 1;
+}
+
+int NCursesDisplay::CoreRows(size_t cores, int columns) {
+  const size_t per_row = std::max(1, columns - 1 - CORE_COLUMN);
+  return static_cast<int>((cores + per_row - 1) / per_row);
 }
 
 void NCursesDisplay::DisplayProcesses(std::vector<Process>& processes,
-                                      WINDOW* window, int n) {
+                                      Canvas& canvas, int n, SortKey sorting) {
   int row{0};
   int const pid_column{2};
   int const user_column{9};
   int const cpu_column{16};
-  int const ram_column{26};
-  int const time_column{35};
-  int const command_column{46};
-  wattron(window, COLOR_PAIR(2));
-  mvwprintw(window, ++row, pid_column, "PID");
-  mvwprintw(window, row, user_column, "USER");
-  mvwprintw(window, row, cpu_column, "CPU[%%]");
-  mvwprintw(window, row, ram_column, "RAM[MB]");
-  mvwprintw(window, row, time_column, "TIME+");
-  mvwprintw(window, row, command_column, "COMMAND");
-  wattroff(window, COLOR_PAIR(2));
+  int const vsz_column{23};
+  int const rss_column{30};
+  int const shared_column{37};
+  int const pss_column{44};
+  int const uss_column{51};
+  int const time_column{58};
+  int const command_column{69};
+  int const command_width{std::max(0, canvas.Columns() - command_column)};
+  LineBuffer line;
+  auto header = [&](int column, int width, const char* title, bool sorted) {
+    attr_t attributes = COLOR_PAIR(2) | (sorted ? A_REVERSE : A_NORMAL);
+    canvas.Print(row, column, title, 0, attributes);
+    canvas.Print(row, column + strlen(title), "",
+                 width - static_cast<int>(strlen(title)));
+  };
+  // Memory in MB; smaps_rollup is only read once a row is on screen
+  auto megabytes = [&line](long kilobytes) {
+    return kilobytes < 0 ? string_view("-")
+                         : Line(line, "%ld", kilobytes / 1024);
+  };
+  ++row;
+  header(pid_column, user_column - pid_column, "PID",
+         sorting == SortKey::kPid);
+  header(user_column, cpu_column - user_column, "USER", false);
+  header(cpu_column, vsz_column - cpu_column, "CPU[%]",
+         sorting == SortKey::kCpu);
+  header(vsz_column, rss_column - vsz_column, "VSZ",
+         sorting == SortKey::kVsz);
+  header(rss_column, shared_column - rss_column, "RSS",
+         sorting == SortKey::kRss);
+  header(shared_column, pss_column - shared_column, "SHR", false);
+  header(pss_column, uss_column - pss_column, "PSS", false);
+  header(uss_column, time_column - uss_column, "USS", false);
+  header(time_column, command_column - time_column, "TIME+",
+         sorting == SortKey::kTime);
+  header(command_column, command_width, "COMMAND", false);
+  int const shown = std::min<int>(n, processes.size());
   for (int i = 0; i < n; ++i) {
+    ++row;
+    // Rows past the end are blanked; every field is padded to its column
+    if (i >= shown) {
+      canvas.Print(row, pid_column, "", canvas.Columns());
+      continue;
+    }
+    const Process& process = processes[i];
     //You need to take care of the fact that the cpu utilization has already been multiplied by 100.
-    // Clear the line
-    mvwprintw(window, ++row, pid_column, (string(window->_maxx-2, ' ').c_str()));
-    
-    mvwprintw(window, row, pid_column, to_string(processes[i].GetPid()).c_str());
-    mvwprintw(window, row, user_column, processes[i].GetUser().c_str());
-    float cpu = processes[i].GetCpuUtilization() * 100;
-    mvwprintw(window, row, cpu_column, to_string(cpu).substr(0, 4).c_str());
-    mvwprintw(window, row, ram_column, processes[i].GetRam().c_str());
-    mvwprintw(window, row, time_column,
-              Format::ElapsedTime(processes[i].GetUpTime()).c_str());
-    mvwprintw(window, row, command_column,
-              processes[i].GetCommand().substr(0, window->_maxx - 46).c_str());
+    canvas.Print(row, pid_column, Line(line, "%d", process.GetPid()),
+                 user_column - pid_column);
+    canvas.Print(row, user_column, process.GetUser(), cpu_column - user_column);
+    canvas.Print(row, cpu_column,
+                 Number(line, process.GetCpuUtilization() * 100, 4),
+                 vsz_column - cpu_column);
+    canvas.Print(row, vsz_column, megabytes(process.GetVsz()),
+                 rss_column - vsz_column);
+    canvas.Print(row, rss_column, megabytes(process.GetRss()),
+                 shared_column - rss_column);
+    canvas.Print(row, shared_column, megabytes(process.GetShared()),
+                 pss_column - shared_column);
+    canvas.Print(row, pss_column, megabytes(process.GetPss()),
+                 uss_column - pss_column);
+    canvas.Print(row, uss_column, megabytes(process.GetUss()),
+                 time_column - uss_column);
+    canvas.Print(row, time_column,
+                 Format::ElapsedTime(process.GetUpTime(), line, kLineSize),
+                 command_column - time_column);
+    canvas.Print(row, command_column,
+                 string_view(process.GetCommand()).substr(0, command_width),
+                 command_width);
+  }
+}
+
+void NCursesDisplay::DisplayGroups(const std::vector<Group>& groups,
+                                   const ProcessTable& table, GroupKey key,
+                                   Canvas& canvas, int n, SortKey sorting) {
+  int row{0};
+  int const count_column{2};
+  int const cpu_column{9};
+  int const rss_column{18};
+  int const vsz_column{27};
+  int const name_column{36};
+  int const name_width{std::max(0, canvas.Columns() - name_column)};
+  LineBuffer line;
+  auto header = [&](int column, int width, const char* title, bool sorted) {
+    attr_t attributes = COLOR_PAIR(2) | (sorted ? A_REVERSE : A_NORMAL);
+    canvas.Print(row, column, title, 0, attributes);
+    canvas.Print(row, column + strlen(title), "",
+                 width - static_cast<int>(strlen(title)));
+  };
+  ++row;
+  header(count_column, cpu_column - count_column, "PROCS",
+         sorting == SortKey::kTime || sorting == SortKey::kPid);
+  header(cpu_column, rss_column - cpu_column, "CPU[%]",
+         sorting == SortKey::kCpu);
+  header(rss_column, vsz_column - rss_column, "RSS[MB]",
+         sorting == SortKey::kRss);
+  header(vsz_column, name_column - vsz_column, "VSZ[MB]",
+         sorting == SortKey::kVsz);
+  header(name_column, name_width,
+         key == GroupKey::kUser      ? "USER"
+         : key == GroupKey::kCommand ? "COMMAND"
+                                     : "PARENT",
+         false);
+  int const shown = std::min<int>(n, groups.size());
+  for (int i = 0; i < n; ++i) {
+    ++row;
+    if (i >= shown) {
+      canvas.Print(row, count_column, "", canvas.Columns());
+      continue;
+    }
+    const Group& group = groups[i];
+    canvas.Print(row, count_column, Line(line, "%u", group.count),
+                 cpu_column - count_column);
+    canvas.Print(row, cpu_column, Line(line, "%.1f", group.cpu * 100),
+                 rss_column - cpu_column);
+    canvas.Print(row, rss_column,
+                 Line(line, "%lld", static_cast<long long>(group.rss / 1024)),
+                 vsz_column - rss_column);
+    canvas.Print(row, vsz_column,
+                 Line(line, "%lld", static_cast<long long>(group.vsz / 1024)),
+                 name_column - vsz_column);
+    string_view name;
+    if (key == GroupKey::kUser) {
+      name = table.users[group.key];
+    } else if (key == GroupKey::kCommand) {
+      name = table.commands[group.key];
+    } else if (group.key < table.Size()) {
+      // The parent's PID, then its command line
+      const string_view command = table.commands[table.command[group.key]];
+      name = Line(line, "%d %.*s", table.pid[group.key],
+                  static_cast<int>(command.size()), command.data());
+    } else {
+      name = "(none)";
+    }
+    canvas.Print(row, name_column, name.substr(0, name_width), name_width);
   }
 }
 
-void NCursesDisplay::Display(System& system, int n) {
+// Subtree totals against an indented command column; row first of the
+// expanded tree is drawn at the top and selected is highlighted
+void NCursesDisplay::DisplayTree(const std::vector<ProcessTree::Row>& rows,
+                                 Canvas& canvas, int n, int first,
+                                 int selected) {
+  int row{0};
+  int const pid_column{2};
+  int const user_column{9};
+  int const cpu_column{16};
+  int const rss_column{26};
+  int const command_column{36};
+  int const command_width{std::max(0, canvas.Columns() - command_column)};
+  LineBuffer line;
+  LineBuffer indented;
+  auto header = [&](int column, int width, const char* title) {
+    canvas.Print(row, column, title, 0, COLOR_PAIR(2));
+    canvas.Print(row, column + strlen(title), "",
+                 width - static_cast<int>(strlen(title)));
+  };
+  ++row;
+  header(pid_column, user_column - pid_column, "PID");
+  header(user_column, cpu_column - user_column, "USER");
+  header(cpu_column, rss_column - cpu_column, "CPU[%]");
+  header(rss_column, command_column - rss_column, "RSS[MB]");
+  header(command_column, command_width, "COMMAND");
+  for (int i = first; i < first + n; ++i) {
+    ++row;
+    if (i >= static_cast<int>(rows.size())) {
+      canvas.Print(row, pid_column, "", canvas.Columns());
+      continue;
+    }
+    const ProcessTree::Row& node = rows[i];
+    const ProcessSnapshot& process = *node.process;
+    const attr_t attributes =
+        process.pid == selected ? A_REVERSE : A_NORMAL;
+    canvas.Print(row, pid_column, Line(line, "%d", process.pid),
+                 user_column - pid_column, attributes);
+    canvas.Print(row, user_column, process.user, cpu_column - user_column,
+                 attributes);
+    // Sums of floats may drift a hair below zero
+    canvas.Print(row, cpu_column,
+                 Line(line, "%.1f", std::max(0.0, node.cpu * 100)),
+                 rss_column - cpu_column, attributes);
+    canvas.Print(row, rss_column,
+                 Line(line, "%lld", static_cast<long long>(node.rss / 1024)),
+                 command_column - rss_column, attributes);
+    // Kernel threads have no command line; show their name like ps does
+    const bool named = process.command.empty();
+    const string_view command = named ? string_view(process.name)
+                                      : process.command;
+    const string_view text =
+        Line(indented, "%*s%c %s%.*s%s", 2 * node.depth, "",
+             !node.parent ? ' ' : node.collapsed ? '+' : '-', named ? "[" : "",
+             static_cast<int>(command.size()), command.data(),
+             named ? "]" : "");
+    canvas.Print(row, command_column, text.substr(0, command_width),
+                 command_width, attributes);
+  }
+}
+
+void NCursesDisplay::DisplayCgroups(
+    const std::vector<const CgroupSnapshot*>& cgroups, Canvas& canvas, int n,
+    SortKey sorting) {
+  int row{0};
+  int const cpu_column{2};
+  int const throttled_column{10};
+  int const memory_column{18};
+  int const file_column{27};
+  int const read_column{36};
+  int const write_column{47};
+  int const count_column{58};
+  int const path_column{65};
+  int const path_width{std::max(0, canvas.Columns() - path_column)};
+  LineBuffer line;
+  auto header = [&](int column, int width, const char* title, bool sorted) {
+    attr_t attributes = COLOR_PAIR(2) | (sorted ? A_REVERSE : A_NORMAL);
+    canvas.Print(row, column, title, 0, attributes);
+    canvas.Print(row, column + strlen(title), "",
+                 width - static_cast<int>(strlen(title)));
+  };
+  ++row;
+  header(cpu_column, throttled_column - cpu_column, "CPU[%]",
+         sorting == SortKey::kCpu);
+  header(throttled_column, memory_column - throttled_column, "THR[%]", false);
+  header(memory_column, file_column - memory_column, "MEM[MB]",
+         sorting == SortKey::kRss);
+  header(file_column, read_column - file_column, "FILE[MB]", false);
+  header(read_column, write_column - read_column, "READ[KB/s]",
+         sorting == SortKey::kTime);
+  header(write_column, count_column - write_column, "WRITE[KB/s]",
+         sorting == SortKey::kTime);
+  header(count_column, path_column - count_column, "PROCS",
+         sorting == SortKey::kPid);
+  header(path_column, path_width, "CGROUP", false);
+  int const shown = std::min<int>(n, cgroups.size());
+  for (int i = 0; i < n; ++i) {
+    ++row;
+    if (i >= shown) {
+      canvas.Print(row, cpu_column, "", canvas.Columns());
+      continue;
+    }
+    const CgroupSnapshot& cgroup = *cgroups[i];
+    canvas.Print(row, cpu_column, Line(line, "%.1f", cgroup.cpu * 100),
+                 throttled_column - cpu_column);
+    canvas.Print(row, throttled_column,
+                 Line(line, "%.1f", cgroup.throttled * 100),
+                 memory_column - throttled_column);
+    canvas.Print(row, memory_column, Line(line, "%ld", cgroup.memory / 1024),
+                 file_column - memory_column);
+    canvas.Print(row, file_column, Line(line, "%ld", cgroup.file / 1024),
+                 read_column - file_column);
+    canvas.Print(row, read_column, Line(line, "%.0f", cgroup.read_rate / 1024),
+                 write_column - read_column);
+    canvas.Print(row, write_column,
+                 Line(line, "%.0f", cgroup.write_rate / 1024),
+                 count_column - write_column);
+    canvas.Print(row, count_column, Line(line, "%d", cgroup.processes),
+                 path_column - count_column);
+    canvas.Print(row, path_column,
+                 string_view(cgroup.path).substr(0, path_width), path_width);
+  }
+}
+
+// Where the monitor's own time went, for the 'i' overlay
+void NCursesDisplay::DisplayInstrumentation(Canvas& canvas) {
+  using Instrumentation::Counter;
+  using Instrumentation::Phase;
+  LineBuffer line;
+  int const width{canvas.Columns()};
+  int row{0};
+  canvas.Print(++row, 2,
+               Line(line, "%-10s %8s %10s %10s %10s", "phase", "count",
+                    "p50 us", "p99 us", "max us"),
+               width, COLOR_PAIR(2));
+  for (int i = 0; i < static_cast<int>(Phase::kCount); ++i) {
+    const Phase phase = static_cast<Phase>(i);
+    const Instrumentation::Summary summary = Instrumentation::Summarize(phase);
+    canvas.Print(++row, 2,
+                 Line(line, "%-10s %8lu %10.1f %10.1f %10.1f",
+                      Instrumentation::Name(phase),
+                      static_cast<unsigned long>(summary.count),
+                      summary.p50_us, summary.p99_us, summary.max_us),
+                 width);
+  }
+  const double ticks = std::max<double>(
+      1, Instrumentation::Summarize(Phase::kRefresh).count);
+  for (int i = 0; i < static_cast<int>(Counter::kCount); ++i) {
+    const Counter counter = static_cast<Counter>(i);
+    canvas.Print(++row, 2,
+                 Line(line, "%-13s %12.1f per tick", Instrumentation::Name(counter),
+                      Instrumentation::Total(counter) / ticks),
+                 width);
+  }
+}
+
+// Map a key press to a sort column; returns false for other keys
+bool NCursesDisplay::SortKeyFor(int key, SortKey& sorting) {
+  switch (key) {
+    case 'c':
+      sorting = SortKey::kCpu;
+      return true;
+    case 'm':
+      sorting = SortKey::kRss;
+      return true;
+    case 'v':
+      sorting = SortKey::kVsz;
+      return true;
+    case 't':
+      sorting = SortKey::kTime;
+      return true;
+    case 'p':
+      sorting = SortKey::kPid;
+      return true;
+  }
+  return false;
+}
+
+void NCursesDisplay::Display(SnapshotSource& source,
+                             std::chrono::milliseconds render_interval,
+                             int n) {
   initscr();      // start ncurses
   noecho();       // do not print input values
   cbreak();       // terminate ncurses on ctrl + c
+  keypad(stdscr, TRUE);  // arrow keys move through the tree
   start_color();  // enable color
+  init_pair(1, COLOR_BLUE, COLOR_BLACK);
+  init_pair(2, COLOR_GREEN, COLOR_BLACK);
+  init_pair(3, COLOR_GREEN, COLOR_BLACK);
+  init_pair(4, COLOR_YELLOW, COLOR_BLACK);
+  init_pair(5, COLOR_RED, COLOR_BLACK);
 
+  // The first snapshot tells how many rows the core strip needs
+  source.Start();
   int x_max{getmaxx(stdscr)};
-  WINDOW* system_window = newwin(9, x_max - 1, 0, 0);
-  WINDOW* process_window =
-      newwin(3 + n, x_max - 1, system_window->_maxy + 1, 0);
-
-  while (1) {
-    init_pair(1, COLOR_BLUE, COLOR_BLACK);
-    init_pair(2, COLOR_GREEN, COLOR_BLACK);
-    box(system_window, 0, 0);
-    box(process_window, 0, 0);
-    DisplaySystem(system, system_window);
-    DisplayProcesses(system.Processes(), process_window, n);
-    wrefresh(system_window);
-    wrefresh(process_window);
-    refresh();
-    std::this_thread::sleep_for(std::chrono::seconds(1));
+  int system_rows{SYSTEM_ROWS +
+                  CoreRows(source.Latest().core_utilization.size(), x_max - 1)};
+  WINDOW* system_window = newwin(system_rows, x_max - 1, 0, 0);
+  WINDOW* process_window = newwin(3 + n, x_max - 1, system_rows, 0);
+  Canvas system_canvas(system_window);
+  Canvas process_canvas(process_window);
+  // Floats over the right end of the process list while shown
+  WINDOW* overlay_window =
+      newwin(OVERLAY_ROWS, OVERLAY_COLUMNS, system_rows,
+             std::max(0, x_max - 1 - OVERLAY_COLUMNS));
+  Canvas overlay_canvas(overlay_window);
+  overlay_canvas.Title(" instrumentation ");
+  bool overlay{false};
+  bool instrumented{false};  // already on when the overlay opened
+  auto layout = [&]() {
+    x_max = getmaxx(stdscr);
+    system_rows = SYSTEM_ROWS + CoreRows(source.Latest().core_utilization.size(),
+                                         x_max - 1);
+    // Whatever the windows no longer cover has to be cleared
+    werase(stdscr);
+    wnoutrefresh(stdscr);
+    system_canvas.Resize(system_rows, x_max - 1);
+    mvwin(process_window, system_rows, 0);
+    process_canvas.Resize(3 + n, x_max - 1);
+    touchwin(process_window);
+    mvwin(overlay_window, system_rows,
+          std::max(0, x_max - 1 - OVERLAY_COLUMNS));
+  };
+
+  // Sampling runs on its own thread; this loop only draws the newest
+  // snapshot and reacts to keys, so a slow /proc scan never blocks it
+  TopProcesses top;
+  GroupBy group_by;
+  GroupKey grouping{GroupKey::kNone};
+  ProcessTree tree;
+  bool tree_view{false};
+  bool cgroup_view{false};
+  std::vector<const CgroupSnapshot*> cgroups;
+  int selected{-1};  // PID highlighted in the tree
+  int first{0};      // row of the tree at the top of the list
+  std::vector<int> visible;
+  // '/' edits the filter in the process list's title until Enter or Esc
+  bool editing{false};
+  string edited;
+  string message;
+  string title;
+  bool redraw{true};
+  bool running{true};
+  while (running) {
+    redraw = source.Update() || redraw;
+    if (redraw) {
+      Instrumentation::ScopedTimer timer(Instrumentation::Phase::kRender);
+      const SystemSnapshot& snapshot = source.Latest();
+      // Cores going on or offline can change the height of the strip
+      if (SYSTEM_ROWS + CoreRows(snapshot.core_utilization.size(),
+                                 x_max - 1) != system_rows) {
+        layout();
+      }
+      system_canvas.Title(source.Status());
+      DisplaySystem(snapshot, system_canvas);
+      if (editing) {
+        title = " filter: " + edited + "_ ";
+      } else if (!message.empty()) {
+        title = " " + message + " ";
+      } else if (!source.Filter().empty()) {
+        title = " filter: " + string(source.Filter()) + " ";
+      } else {
+        title.clear();
+      }
+      process_canvas.Title(title);
+      visible.clear();
+      if (cgroup_view) {
+        // Busiest first by the process list's sort key
+        cgroups.clear();
+        for (const CgroupSnapshot& cgroup : snapshot.cgroups) {
+          cgroups.push_back(&cgroup);
+        }
+        const auto weight = [sorting = top.Sorting()](const CgroupSnapshot* a) {
+          switch (sorting) {
+            case SortKey::kCpu:
+              return static_cast<double>(a->cpu);
+            case SortKey::kRss:
+              return static_cast<double>(a->memory);
+            case SortKey::kTime:
+              return a->read_rate + a->write_rate;
+            default:
+              return static_cast<double>(a->processes);
+          }
+        };
+        const size_t shown = std::min<size_t>(n, cgroups.size());
+        std::partial_sort(cgroups.begin(), cgroups.begin() + shown,
+                          cgroups.end(),
+                          [&weight](const CgroupSnapshot* a,
+                                    const CgroupSnapshot* b) {
+                            return weight(a) > weight(b);
+                          });
+        cgroups.resize(shown);
+        DisplayCgroups(cgroups, process_canvas, n, top.Sorting());
+      } else if (tree_view) {
+        // Only what changed since the last snapshot is applied
+        tree.Update(snapshot.processes);
+        const std::vector<ProcessTree::Row>& rows = tree.Rows();
+        auto at = std::find_if(rows.begin(), rows.end(),
+                               [selected](const ProcessTree::Row& row) {
+                                 return row.process->pid == selected;
+                               });
+        int index = at - rows.begin();
+        if (at == rows.end()) {
+          // The selected process exited or was folded away
+          index = std::min<int>(first, rows.size() - 1);
+          selected = index >= 0 ? rows[index].process->pid : -1;
+        }
+        first = std::clamp(first, std::max(0, index - n + 1),
+                           std::max(0, index));
+        DisplayTree(rows, process_canvas, n, first, selected);
+        for (int i = first; i < std::min<int>(first + n, rows.size()); ++i) {
+          visible.push_back(rows[i].process->pid);
+        }
+      } else if (grouping == GroupKey::kNone) {
+        std::vector<Process>& processes = top.Select(snapshot, n);
+        DisplayProcesses(processes, process_canvas, n, top.Sorting());
+        for (const Process& process : processes) {
+          visible.push_back(process.GetPid());
+        }
+      } else {
+        DisplayGroups(
+            group_by.Select(snapshot.table, grouping, top.Sorting(), n),
+            snapshot.table, grouping, process_canvas, n, top.Sorting());
+      }
+      source.Prioritize(visible);
+      wnoutrefresh(system_window);
+      wnoutrefresh(process_window);
+      if (overlay) {
+        DisplayInstrumentation(overlay_canvas);
+        // The process list below may have repainted these cells
+        touchwin(overlay_window);
+        wnoutrefresh(overlay_window);
+      }
+      doupdate();
+    }
+
+    timeout(render_interval.count());
+    int const key = getch();
+    if (editing) {
+      if (key == '\n' || key == KEY_ENTER) {
+        editing = false;
+        message.clear();
+        try {
+          if (!source.FilterBy(ProcessFilter(edited))) {
+            message = "filtering needs live sampling";
+          }
+        } catch (const std::invalid_argument& error) {
+          message = error.what();
+        }
+      } else if (key == 27) {
+        editing = false;
+      } else if (key == KEY_BACKSPACE || key == 127 || key == '\b') {
+        if (!edited.empty()) edited.pop_back();
+      } else if (key >= ' ' && key < 127) {
+        edited.push_back(static_cast<char>(key));
+      }
+      redraw = key != ERR;
+      continue;
+    }
+    if (key == '/') {
+      editing = true;
+      edited.assign(source.Filter());
+      redraw = true;
+      continue;
+    }
+    SortKey sorting;
+    // Cgroups have no virtual size to order by
+    redraw = SortKeyFor(key, sorting) &&
+             !(cgroup_view && sorting == SortKey::kVsz);
+    if (redraw) {
+      top.SortBy(sorting);
+    } else {
+      redraw = source.HandleKey(key);
+    }
+    if (key == 'a') {
+      grouping = NextGroupKey(grouping);
+      tree_view = cgroup_view = false;
+      redraw = true;
+    }
+    if (key == 'f') {
+      tree_view = !tree_view;
+      cgroup_view = false;
+      redraw = true;
+    }
+    if (key == 'C') {
+      cgroup_view = !cgroup_view;
+      tree_view = false;
+      if (cgroup_view && top.Sorting() == SortKey::kVsz) {
+        top.SortBy(SortKey::kRss);
+      }
+      redraw = true;
+    }
+    if (tree_view && (key == KEY_UP || key == KEY_DOWN)) {
+      const std::vector<ProcessTree::Row>& rows = tree.Rows();
+      for (size_t i = 0; i < rows.size(); ++i) {
+        if (rows[i].process->pid != selected) continue;
+        if (key == KEY_UP && i > 0) selected = rows[i - 1].process->pid;
+        if (key == KEY_DOWN && i + 1 < rows.size()) {
+          selected = rows[i + 1].process->pid;
+        }
+        break;
+      }
+      redraw = true;
+    }
+    if (tree_view && (key == '-' || key == KEY_LEFT || key == '+' ||
+                      key == KEY_RIGHT)) {
+      tree.Collapse(selected, key == '-' || key == KEY_LEFT);
+      redraw = true;
+    }
+    if (key == 'i') {
+      overlay = !overlay;
+      if (overlay) {
+        // Only what the overlay turned on is turned off with it, not
+        // --instrument
+        instrumented = Instrumentation::Enabled();
+        Instrumentation::Enable();
+      } else {
+        if (!instrumented) Instrumentation::Disable();
+        touchwin(process_window);
+      }
+      redraw = true;
+    }
+    if (key == KEY_RESIZE) {
+      layout();
+      redraw = true;
+    }
+    running = key != 'q';
   }
+  source.Stop();
   endwin();
 }
@@ -0,0 +1,214 @@
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#include "options.h"
+#include "process_filter.h"
+
+#define MIN_INTERVAL_MS 10
+
+using std::string;
+
+namespace {
+// Value following a flag, e.g. "8" in "--threads 8"
+string Value(int argc, char* argv[], int& index) {
+  if (index + 1 >= argc) {
+    throw std::invalid_argument(string("missing value for ") + argv[index]);
+  }
+  return argv[++index];
+}
+
+int Integer(const string& flag, const string& value, int minimum) {
+  size_t used = 0;
+  int result = 0;
+  try {
+    result = std::stoi(value, &used);
+  } catch (const std::exception&) {
+    used = 0;
+  }
+  if (used != value.size() || result < minimum) {
+    throw std::invalid_argument("invalid value for " + flag + ": " + value);
+  }
+  return result;
+}
+
+// Seconds, fractions allowed, e.g. "0.25"
+std::chrono::milliseconds Interval(const string& flag, const string& value) {
+  size_t used = 0;
+  double seconds = 0;
+  try {
+    seconds = std::stod(value, &used);
+  } catch (const std::exception&) {
+    used = 0;
+  }
+  if (used != value.size() || !(seconds * 1000 >= MIN_INTERVAL_MS)) {
+    throw std::invalid_argument("invalid value for " + flag + ": " + value);
+  }
+  return std::chrono::milliseconds(static_cast<long>(seconds * 1000));
+}
+}  // namespace
+
+Options ParseOptions(int argc, char* argv[]) {
+  Options options;
+
+  for (int i = 1; i < argc; ++i) {
+    const string flag = argv[i];
+    if (flag == "-h" || flag == "--help") {
+      options.help = true;
+    } else if (flag == "--threads") {
+      options.threads = Integer(flag, Value(argc, argv, i), 0);
+    } else if (flag == "--instrument") {
+      options.instrument = true;
+    } else if (flag == "--events") {
+      options.events = true;
+    } else if (flag == "--memory-interval") {
+      options.memory_interval = Integer(flag, Value(argc, argv, i), 1);
+    } else if (flag == "--budget") {
+      options.budget = Integer(flag, Value(argc, argv, i), 0);
+    } else if (flag == "--filter") {
+      options.filter = Value(argc, argv, i);
+      ProcessFilter{options.filter};  // throws on a malformed filter
+    } else if (flag == "--batch") {
+      options.batch = true;
+    } else if (flag == "-n") {
+      options.iterations = Integer(flag, Value(argc, argv, i), 0);
+    } else if (flag == "--format") {
+      const string format = Value(argc, argv, i);
+      if (format == "csv") {
+        options.format = OutputFormat::kCsv;
+      } else if (format == "json") {
+        options.format = OutputFormat::kJson;
+      } else {
+        throw std::invalid_argument("invalid value for " + flag + ": " +
+                                    format);
+      }
+    } else if (flag == "--sample-interval" || flag == "-d") {
+      options.sample_interval = Interval(flag, Value(argc, argv, i));
+    } else if (flag == "--render-interval") {
+      options.render_interval = Interval(flag, Value(argc, argv, i));
+    } else if (flag == "--record") {
+      options.record = Value(argc, argv, i);
+    } else if (flag == "--record-size") {
+      options.record_size =
+          static_cast<std::size_t>(Integer(flag, Value(argc, argv, i), 1))
+          << 20;
+    } else if (flag == "--replay") {
+      options.replay = Value(argc, argv, i);
+    } else if (flag == "--publish") {
+      options.publish = true;
+    } else if (flag == "--attach") {
+      options.attach = true;
+    } else if (flag == "--shm") {
+      options.shm_name = Value(argc, argv, i);
+      if (options.shm_name.empty() ||
+          options.shm_name.find('/') != string::npos) {
+        throw std::invalid_argument("invalid value for " + flag + ": " +
+                                    options.shm_name);
+      }
+    } else if (flag == "--shm-size") {
+      options.shm_size =
+          static_cast<std::size_t>(Integer(flag, Value(argc, argv, i), 1))
+          << 20;
+    } else if (flag == "--listen") {
+      options.listen = Value(argc, argv, i);
+      const size_t colon = options.listen.rfind(':');
+      const string port =
+          colon == string::npos ? string() : options.listen.substr(colon + 1);
+      if (port.empty() ||
+          port.find_first_not_of("0123456789") != string::npos) {
+        throw std::invalid_argument("invalid value for " + flag + ": " +
+                                    options.listen);
+      }
+    } else if (flag == "--metrics-top") {
+      options.metrics_top = Integer(flag, Value(argc, argv, i), 1);
+    } else if (flag == "--proc-root") {
+      options.proc_root = Value(argc, argv, i);
+    } else if (flag == "--etc-root") {
+      options.etc_root = Value(argc, argv, i);
+    } else if (flag == "--cgroup-root") {
+      options.cgroup_root = Value(argc, argv, i);
+    } else {
+      throw std::invalid_argument("unknown option " + flag);
+    }
+  }
+  // --listen runs headless like --publish and may go along with it
+  const int modes = (options.publish || !options.listen.empty()) +
+                    options.attach + options.batch + !options.replay.empty();
+  if (modes > 1) {
+    throw std::invalid_argument(
+        "--publish or --listen, --attach, --batch and --replay exclude each "
+        "other");
+  }
+  if (options.threads == 0) {
+    options.threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  return options;
+}
+
+string Usage(const string& program) {
+  return "usage: " + program +
+         " [--threads N] [--events] [--instrument]\n"
+         "       [--memory-interval N] [--budget PERCENT] [--filter EXPR]\n"
+         "       [--sample-interval SEC]"
+         " [--render-interval SEC] [--record FILE [--record-size MB]]\n"
+         "       " + program + " --replay FILE [--render-interval SEC]\n"
+         "       " + program + " --publish [--shm NAME] [--shm-size MB]"
+         " [--sample-interval SEC]\n"
+         "       " + program +
+         " --listen ADDR:PORT [--metrics-top N] [--publish ...]"
+         " [--sample-interval SEC]\n"
+         "       " + program +
+         " --attach [--shm NAME] [--render-interval SEC]\n"
+         "       " + program +
+         " --batch [-n N] [-d SEC] [--format csv|json] [--threads N]\n"
+         "  -h, --help               show this message\n"
+         "  --threads N              scan /proc with N threads (0: one per "
+         "core)\n"
+         "  --proc-root DIR          read DIR instead of /proc\n"
+         "  --etc-root DIR           read DIR instead of /etc\n"
+         "  --cgroup-root DIR        read the cgroup v2 tree at DIR instead of "
+         "/sys/fs/cgroup\n"
+         "  --events                 follow forks and exits through the proc "
+         "connector\n"
+         "                           instead of listing /proc every tick\n"
+         "  --memory-interval N      read the memory of idle processes every "
+         "N ticks\n"
+         "                           (default 4)\n"
+         "  --budget PERCENT         share of one CPU a tick may take; idle "
+         "processes\n"
+         "                           are read less often while over it\n"
+         "  --filter EXPR            show only matching processes, e.g. "
+         "\"user=root cpu>5\"\n"
+         "                           (terms: user= uid= name~ cmd~ state= "
+         "cpu> mem>)\n"
+         "  --instrument             time the monitor's own phases from the "
+         "start and\n"
+         "                           print them to stderr on exit\n"
+         "  --sample-interval SEC    seconds between /proc scans (default 1)\n"
+         "  --render-interval SEC    seconds between redraws (default 0.25)\n"
+         "  --batch                  print samples to stdout instead of the "
+         "UI\n"
+         "  -n N                     stop after N samples (default 0: never)\n"
+         "  -d SEC                   same as --sample-interval\n"
+         "  --format csv|json        CSV rows per process or one JSON line "
+         "per sample\n"
+         "  --record FILE            also write every sample to a ring file\n"
+         "  --record-size MB         size of the ring (default 256)\n"
+         "  --replay FILE            play a recording back instead of "
+         "sampling\n"
+         "  --publish                sample without a UI into shared memory "
+         "for viewers\n"
+         "  --attach                 show what --publish samples instead of "
+         "sampling\n"
+         "  --shm NAME               shared memory segment /NAME (default "
+         "monitor)\n"
+         "  --shm-size MB            size of the segment (default 64)\n"
+         "  --listen ADDR:PORT       sample without a UI and serve /metrics "
+         "for Prometheus,\n"
+         "                           e.g. :9100 or 127.0.0.1:9100\n"
+         "  --metrics-top N          export single processes only for the "
+         "top N by CPU\n"
+         "                           and by RSS (default 10)\n";
+}
@@ -0,0 +1,113 @@
+#include <errno.h>
+#include <unistd.h>
+#include <algorithm>
+#include <charconv>
+#include <cstddef>
+#include <string_view>
+
+#include "output_buffer.h"
+
+// Longest number to_chars can produce for the types appended here
+#define MAX_NUMBER 64
+
+using std::size_t;
+using std::string_view;
+
+OutputBuffer::OutputBuffer(int output_descriptor, size_t capacity)
+    : descriptor(output_descriptor), buffer(capacity) {}
+
+OutputBuffer::~OutputBuffer() { Flush(); }
+
+void OutputBuffer::Reserve(size_t size) {
+  if (buffer.size() - length >= size) return;
+  Flush();
+  if (buffer.size() < size) buffer.resize(size);
+}
+
+bool OutputBuffer::Flush() {
+  size_t written = 0;
+  while (!failed && written < length) {
+    ssize_t count = write(descriptor, buffer.data() + written, length - written);
+    if (count < 0) {
+      if (errno == EINTR) continue;
+      failed = true;
+      break;
+    }
+    written += count;
+  }
+  length = 0;
+  return !failed;
+}
+
+void OutputBuffer::Append(string_view text) {
+  // Large texts go through in buffer sized pieces
+  while (!text.empty()) {
+    Reserve(1);
+    size_t count = std::min(text.size(), buffer.size() - length);
+    text.copy(buffer.data() + length, count);
+    length += count;
+    text.remove_prefix(count);
+  }
+}
+
+void OutputBuffer::Append(char character) {
+  Reserve(1);
+  buffer[length++] = character;
+}
+
+void OutputBuffer::Append(long value) {
+  Reserve(MAX_NUMBER);
+  char* first = buffer.data() + length;
+  length = std::to_chars(first, first + MAX_NUMBER, value).ptr - buffer.data();
+}
+
+void OutputBuffer::Append(unsigned long value) {
+  Reserve(MAX_NUMBER);
+  char* first = buffer.data() + length;
+  length = std::to_chars(first, first + MAX_NUMBER, value).ptr - buffer.data();
+}
+
+void OutputBuffer::Append(int value) { Append(static_cast<long>(value)); }
+
+void OutputBuffer::Append(double value, int precision) {
+  Reserve(MAX_NUMBER);
+  char* first = buffer.data() + length;
+  auto result = std::to_chars(first, first + MAX_NUMBER, value,
+                              std::chars_format::fixed, precision);
+  if (result.ec != std::errc()) {
+    Append('0');
+    return;
+  }
+  length = result.ptr - buffer.data();
+}
+
+void OutputBuffer::AppendJson(string_view text) {
+  static const char hex[] = "0123456789abcdef";
+  Append('"');
+  for (char character : text) {
+    const unsigned char code = static_cast<unsigned char>(character);
+    if (character == '"' || character == '\\') {
+      Append('\\');
+      Append(character);
+    } else if (code < 0x20) {
+      char escape[] = {'\\', 'u', '0', '0', hex[code >> 4], hex[code & 0xf]};
+      Append(string_view(escape, sizeof(escape)));
+    } else {
+      Append(character);
+    }
+  }
+  Append('"');
+}
+
+void OutputBuffer::AppendCsv(string_view text) {
+  if (text.find_first_of(",\"\r\n") == string_view::npos) {
+    Append(text);
+    return;
+  }
+  Append('"');
+  for (char character : text) {
+    if (character == '"') Append('"');
+    Append(character);
+  }
+  Append('"');
+}
@@ -0,0 +1,195 @@
+#include <linux/cn_proc.h>
+#include <linux/connector.h>
+#include <linux/netlink.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "proc_events.h"
+
+#define RECEIVE_BUFFER 16384
+// How long the kernel gets to acknowledge the subscription
+#define ACK_TIMEOUT std::chrono::milliseconds(250)
+// Tells our acknowledgement from those of other listeners
+#define LISTEN_ACK 0x6d6f6e
+
+using std::vector;
+
+namespace {
+std::runtime_error Failure(const char* what, int error = errno) {
+  return std::runtime_error(std::string("process events: ") + what + ": " +
+                            std::strerror(error));
+}
+
+// The proc_event in a connector message, or nullptr for anything else
+const cn_msg* ProcMessage(const nlmsghdr* header) {
+  if (header->nlmsg_type == NLMSG_ERROR || header->nlmsg_type == NLMSG_NOOP) {
+    return nullptr;
+  }
+  const cn_msg* message = static_cast<const cn_msg*>(NLMSG_DATA(header));
+  if (message->id.idx != CN_IDX_PROC || message->id.val != CN_VAL_PROC ||
+      message->len < sizeof(proc_event)) {
+    return nullptr;
+  }
+  return message;
+}
+}  // namespace
+
+ProcEvents::ProcEvents() {
+  socket_fd = socket(PF_NETLINK, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC,
+                     NETLINK_CONNECTOR);
+  if (socket_fd < 0) throw Failure("socket");
+
+  sockaddr_nl address{};
+  address.nl_family = AF_NETLINK;
+  address.nl_groups = CN_IDX_PROC;
+  if (bind(socket_fd, reinterpret_cast<sockaddr*>(&address),
+           sizeof(address)) != 0) {
+    close(socket_fd);
+    throw Failure("bind");
+  }
+
+  // netlink header, connector header and the operation, back to back
+  alignas(nlmsghdr) char
+      request[NLMSG_SPACE(sizeof(cn_msg) + sizeof(proc_cn_mcast_op))] = {};
+  nlmsghdr* header = reinterpret_cast<nlmsghdr*>(request);
+  header->nlmsg_len = NLMSG_LENGTH(sizeof(cn_msg) + sizeof(proc_cn_mcast_op));
+  header->nlmsg_type = NLMSG_DONE;
+  cn_msg* message = static_cast<cn_msg*>(NLMSG_DATA(header));
+  message->id.idx = CN_IDX_PROC;
+  message->id.val = CN_VAL_PROC;
+  message->ack = LISTEN_ACK;
+  message->len = sizeof(proc_cn_mcast_op);
+  const proc_cn_mcast_op operation = PROC_CN_MCAST_LISTEN;
+  std::memcpy(message->data, &operation, sizeof(operation));
+  if (send(socket_fd, request, header->nlmsg_len, 0) < 0) {
+    close(socket_fd);
+    throw Failure("listen");
+  }
+  const int error = Acknowledgement();
+  if (error != 0) {
+    close(socket_fd);
+    throw Failure("listen", error);
+  }
+}
+
+// A sent request is no subscription yet: the kernel answers it with an
+// error of EPERM without CAP_NET_ADMIN, and not at all outside the
+// initial namespaces. Events that arrive first are dropped; the first
+// Poll does not trust its list anyway.
+int ProcEvents::Acknowledgement() {
+  alignas(nlmsghdr) char buffer[RECEIVE_BUFFER];
+  const auto deadline = std::chrono::steady_clock::now() + ACK_TIMEOUT;
+  while (true) {
+    const auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+        deadline - std::chrono::steady_clock::now());
+    if (left.count() <= 0) return ETIMEDOUT;
+    pollfd descriptor{socket_fd, POLLIN, 0};
+    if (poll(&descriptor, 1, static_cast<int>(left.count())) < 0 &&
+        errno != EINTR) {
+      return errno;
+    }
+    const ssize_t received = recv(socket_fd, buffer, sizeof(buffer), 0);
+    if (received < 0) {
+      if (errno == EINTR || errno == EAGAIN || errno == ENOBUFS) continue;
+      return errno;
+    }
+    int length = static_cast<int>(received);
+    for (nlmsghdr* header = reinterpret_cast<nlmsghdr*>(buffer);
+         NLMSG_OK(header, length); header = NLMSG_NEXT(header, length)) {
+      const cn_msg* message = ProcMessage(header);
+      if (!message || message->ack != LISTEN_ACK + 1) continue;
+      proc_event event;
+      std::memcpy(&event, message->data, sizeof(event));
+      if (event.what == proc_event::PROC_EVENT_NONE) {
+        return static_cast<int>(event.event_data.ack.err);
+      }
+    }
+  }
+}
+
+ProcEvents::~ProcEvents() {
+  if (socket_fd >= 0) close(socket_fd);
+}
+
+bool ProcEvents::Poll(vector<int>& pids, vector<int>& stale) {
+  alignas(nlmsghdr) char buffer[RECEIVE_BUFFER];
+  while (true) {
+    const ssize_t received = recv(socket_fd, buffer, sizeof(buffer), 0);
+    if (received < 0) {
+      if (errno == EINTR) continue;
+      // The kernel dropped messages because we fell behind
+      if (errno == ENOBUFS) {
+        lost = true;
+        continue;
+      }
+      break;  // EAGAIN: nothing pending
+    }
+    int length = static_cast<int>(received);
+    for (nlmsghdr* header = reinterpret_cast<nlmsghdr*>(buffer);
+         NLMSG_OK(header, length); header = NLMSG_NEXT(header, length)) {
+      const cn_msg* message = ProcMessage(header);
+      if (!message) continue;
+      // The event is not aligned inside the message
+      proc_event event;
+      std::memcpy(&event, message->data, sizeof(event));
+      // Acknowledgements of other listeners carry no CPU or sequence
+      if (event.what == proc_event::PROC_EVENT_NONE) continue;
+      // Sequence numbers count up per CPU; a gap means a lost event
+      const uint32_t cpu = event.cpu;
+      if (cpu >= sequences.size()) {
+        sequences.resize(cpu + 1);
+        seen.resize(cpu + 1);
+      }
+      if (seen[cpu] && message->seq != sequences[cpu]) lost = true;
+      seen[cpu] = true;
+      sequences[cpu] = message->seq + 1;
+      Apply(event, stale);
+    }
+  }
+  // One merge for the whole batch instead of an insert per fork
+  if (!added.empty()) {
+    std::sort(added.begin(), added.end());
+    const std::size_t middle = pids.size();
+    pids.insert(pids.end(), added.begin(), added.end());
+    std::inplace_merge(pids.begin(), pids.begin() + middle, pids.end());
+    pids.erase(std::unique(pids.begin(), pids.end()), pids.end());
+    added.clear();
+  }
+  const bool trusted = !lost;
+  lost = false;
+  return trusted;
+}
+
+// Only whole processes matter: events of other threads are ignored.
+// An exited process stays listed, since it lingers as a zombie until its
+// parent reaps it; the caller drops PIDs once /proc no longer has them.
+void ProcEvents::Apply(const proc_event& event, vector<int>& stale) {
+  switch (event.what) {
+    case proc_event::PROC_EVENT_FORK:
+      if (event.event_data.fork.child_pid ==
+          event.event_data.fork.child_tgid) {
+        added.push_back(event.event_data.fork.child_tgid);
+      }
+      break;
+    case proc_event::PROC_EVENT_EXEC:
+      stale.push_back(event.event_data.exec.process_tgid);
+      break;
+    case proc_event::PROC_EVENT_EXIT:
+      if (event.event_data.exit.process_pid ==
+          event.event_data.exit.process_tgid) {
+        stale.push_back(event.event_data.exit.process_tgid);
+      }
+      break;
+    default:
+      break;
+  }
+}
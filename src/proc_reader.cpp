@@ -0,0 +1,133 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <charconv>
+#include <string>
+#include <string_view>
+
+#include "instrumentation.h"
+#include "linux_parser.h"
+#include "proc_reader.h"
+
+#define MAX_DIGITS 16
+
+using std::string;
+using std::string_view;
+
+ProcReader::ProcReader(std::size_t capacity) : buffer(capacity) {
+  path.reserve(LinuxParser::ProcDirectory().size() + 64);
+}
+
+// Files under /proc report a size of 0, so read until EOF and grow the
+// buffer whenever a file fills it
+bool ProcReader::Read(const char* file_path, string_view& content) {
+  int descriptor = open(file_path, O_RDONLY | O_CLOEXEC);
+  if (descriptor < 0) return false;
+  Instrumentation::Add(Instrumentation::Counter::kFilesOpened);
+
+  std::size_t length = 0;
+  bool success = true;
+  while (true) {
+    if (length == buffer.size()) buffer.resize(buffer.size() * 2);
+    ssize_t count =
+        read(descriptor, buffer.data() + length, buffer.size() - length);
+    if (count < 0) {
+      if (errno == EINTR) continue;
+      success = false;
+      break;
+    }
+    if (count == 0) break;
+    length += count;
+  }
+  close(descriptor);
+  Instrumentation::Add(Instrumentation::Counter::kBytesRead, length);
+
+  content = success ? string_view(buffer.data(), length) : string_view();
+  return success;
+}
+
+bool ProcReader::Read(const string& file_path, string_view& content) {
+  return Read(file_path.c_str(), content);
+}
+
+bool ProcReader::ReadProc(const string& filename, string_view& content) {
+  path.assign(LinuxParser::ProcDirectory());
+  path.append(filename);
+  return Read(path.c_str(), content);
+}
+
+bool ProcReader::Read(int pid, const string& filename, string_view& content) {
+  char digits[MAX_DIGITS];
+  auto result = std::to_chars(digits, digits + MAX_DIGITS, pid);
+
+  path.assign(LinuxParser::ProcDirectory());
+  path.append(digits, result.ptr);
+  path.append(filename);
+  return Read(path.c_str(), content);
+}
+
+void ProcParse::Skip(string_view& text, int count) {
+  for (int i = 0; i < count; ++i) {
+    std::size_t start = text.find_first_not_of(" \t\n");
+    if (start == string_view::npos) {
+      text = string_view();
+      return;
+    }
+    std::size_t end = text.find_first_of(" \t\n", start);
+    text.remove_prefix(end == string_view::npos ? text.size() : end);
+  }
+}
+
+string_view ProcParse::Line(string_view& text) {
+  std::size_t end = text.find('\n');
+  string_view line = text.substr(0, end);
+  text.remove_prefix(end == string_view::npos ? text.size() : end + 1);
+  return line;
+}
+
+bool ProcParse::Stat(string_view content, PidStat& stat) {
+  std::size_t comm_start = content.find('(');
+  std::size_t comm_end = content.rfind(')');
+  if (comm_start == string_view::npos || comm_end == string_view::npos ||
+      comm_end < comm_start) {
+    return false;
+  }
+  stat.comm = content.substr(comm_start + 1, comm_end - comm_start - 1);
+
+  // The remainder starts at field 3 (state)
+  string_view fields = content.substr(comm_end + 1);
+  std::size_t state = fields.find_first_not_of(' ');
+  if (state == string_view::npos) return false;
+  stat.state = fields[state];
+  fields.remove_prefix(state + 1);
+
+  if (!Number(fields, stat.ppid)) return false;
+  Skip(fields, 9);  // fields 5 - 13
+  if (!Number(fields, stat.utime) || !Number(fields, stat.stime)) return false;
+  Skip(fields, 6);  // fields 16 - 21
+  return Number(fields, stat.starttime);
+}
+
+bool ProcParse::Statm(string_view content, PidStatm& statm) {
+  return Number(content, statm.size) && Number(content, statm.resident) &&
+         Number(content, statm.shared);
+}
+
+bool ProcParse::Smaps(string_view content, PidSmaps& smaps) {
+  bool found = false;
+  while (!content.empty()) {
+    string_view line = Line(content);
+    const size_t colon = line.find(':');
+    if (colon == string_view::npos) continue;
+    const string_view key = line.substr(0, colon);
+    line.remove_prefix(colon + 1);
+    if (key == "Pss") {
+      found = Number(line, smaps.pss);
+    } else if (key == "Private_Clean") {
+      Number(line, smaps.private_clean);
+    } else if (key == "Private_Dirty") {
+      Number(line, smaps.private_dirty);
+    }
+  }
+  return found;
+}
@@ -0,0 +1,191 @@
+#include <algorithm>
+#include <regex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#include "linux_parser.h"
+#include "process_filter.h"
+
+using LinuxParser::kCommandFields;
+using LinuxParser::kMemoryFields;
+using LinuxParser::kStatFields;
+using LinuxParser::kStatusFields;
+using std::string;
+
+namespace {
+// Order in which the sampler can check a source: stat is read for every
+// process anyway, status is short, statm a little longer and cmdline
+// the longest; the CPU share is only known after all of them
+int Cost(unsigned source) {
+  switch (source) {
+    case kStatFields:
+      return 0;
+    case kStatusFields:
+      return 1;
+    case kMemoryFields:
+      return 2;
+    case kCommandFields:
+      return 3;
+  }
+  return 4;
+}
+
+bool Compare(double value, char operation, double number) {
+  switch (operation) {
+    case '<':
+      return value < number;
+    case '>':
+      return value > number;
+  }
+  return value == number;
+}
+}  // namespace
+
+ProcessFilter::ProcessFilter(const string& input_text) : text(input_text) {
+  std::istringstream stream(text);
+  string term;
+  while (stream >> term) {
+    terms.push_back(Parse(term));
+    fields |= terms.back().source;
+  }
+  std::stable_sort(terms.begin(), terms.end(),
+                   [](const Term& a, const Term& b) {
+                     return Cost(a.source) < Cost(b.source);
+                   });
+}
+
+ProcessFilter::Term ProcessFilter::Parse(const string& term) {
+  const auto invalid = [&term]() {
+    return std::invalid_argument("invalid filter term: " + term);
+  };
+  const size_t at = term.find_first_of("!=~<>");
+  if (at == string::npos || at == 0) throw invalid();
+  const string name = term.substr(0, at);
+  size_t value_at = at;
+  Term result{};
+  result.negated = term[value_at] == '!';
+  if (result.negated) ++value_at;
+  if (value_at >= term.size()) throw invalid();
+  result.operation = term[value_at++];
+  result.text = term.substr(value_at);
+  result.uid = -1;
+  if (result.text.empty()) throw invalid();
+
+  bool numeric = false;
+  if (name == "user") {
+    result.field = Field::kUser;
+    result.source = kStatusFields;
+  } else if (name == "uid") {
+    result.field = Field::kUid;
+    result.source = kStatusFields;
+    numeric = true;
+  } else if (name == "name") {
+    result.field = Field::kName;
+    result.source = kStatFields;
+  } else if (name == "cmd") {
+    result.field = Field::kCommand;
+    result.source = kCommandFields;
+  } else if (name == "state") {
+    result.field = Field::kState;
+    result.source = kStatFields;
+  } else if (name == "cpu") {
+    result.field = Field::kCpu;
+    result.source = kUsage;
+    numeric = true;
+  } else if (name == "mem") {
+    result.field = Field::kMemory;
+    result.source = kMemoryFields;
+    numeric = true;
+  } else {
+    throw invalid();
+  }
+
+  const char operation = result.operation;
+  if (numeric) {
+    if (operation != '=' && operation != '<' && operation != '>') {
+      throw invalid();
+    }
+    size_t used = 0;
+    try {
+      result.number = std::stod(result.text, &used);
+    } catch (const std::exception&) {
+      used = 0;
+    }
+    if (used != result.text.size()) throw invalid();
+  } else if (operation == '~' && (result.field == Field::kName ||
+                                  result.field == Field::kCommand)) {
+    try {
+      result.pattern = std::regex(result.text, std::regex::optimize);
+    } catch (const std::regex_error&) {
+      throw invalid();
+    }
+  } else if (operation != '=') {
+    throw invalid();
+  }
+  return result;
+}
+
+bool ProcessFilter::Empty() const { return terms.empty(); }
+
+const string& ProcessFilter::Text() const { return text; }
+
+unsigned ProcessFilter::Fields() const { return fields; }
+
+bool ProcessFilter::Lasting() const {
+  return std::all_of(terms.begin(), terms.end(), [](const Term& term) {
+    return term.field != Field::kState && term.field != Field::kCpu &&
+           term.field != Field::kMemory;
+  });
+}
+
+void ProcessFilter::Resolve(UserCache& users) {
+  for (Term& term : terms) {
+    if (term.field == Field::kUser) term.uid = users.Uid(term.text);
+  }
+}
+
+bool ProcessFilter::Match(const ProcessSnapshot& process, unsigned available,
+                          unsigned& checked) const {
+  const unsigned now = available & ~checked;
+  checked |= available;
+  if ((fields & now) == 0) return true;
+  for (const Term& term : terms) {
+    if ((term.source & now) && !Holds(term, process)) return false;
+  }
+  return true;
+}
+
+bool ProcessFilter::Holds(const Term& term, const ProcessSnapshot& process) {
+  bool result = false;
+  switch (term.field) {
+    case Field::kUser:
+      result = term.uid >= 0 && process.uid == term.uid;
+      break;
+    case Field::kUid:
+      result = Compare(process.uid, term.operation, term.number);
+      break;
+    case Field::kName:
+    case Field::kCommand: {
+      const std::string_view value = term.field == Field::kName
+                                         ? std::string_view(process.name)
+                                         : process.command;
+      result = term.operation == '~'
+                   ? std::regex_search(value.begin(), value.end(), term.pattern)
+                   : value == term.text;
+      break;
+    }
+    case Field::kState:
+      result = term.text.find(process.state) != string::npos;
+      break;
+    case Field::kCpu:
+      result = Compare(process.cpu_utilization * 100, term.operation,
+                       term.number);
+      break;
+    case Field::kMemory:
+      result = Compare(process.rss / 1024.0, term.operation, term.number);
+      break;
+  }
+  return result != term.negated;
+}
@@ -0,0 +1,67 @@
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string_view>
+#include <vector>
+
+#include "process_table.h"
+
+using std::size_t;
+using std::string_view;
+using std::vector;
+
+// Sized for every text being distinct, so it is never more than half full
+void ProcessTableBuilder::Dictionary::Reset(size_t capacity,
+                                            vector<string_view>& input_texts) {
+  size_t size = 16;
+  while (size < 2 * capacity) size *= 2;
+  slots.assign(size, 0);
+  texts = &input_texts;
+  texts->clear();
+}
+
+uint32_t ProcessTableBuilder::Dictionary::Id(string_view text) {
+  const size_t mask = slots.size() - 1;
+  size_t slot = std::hash<string_view>()(text) & mask;
+  while (slots[slot] != 0) {
+    const uint32_t id = slots[slot] - 1;
+    if ((*texts)[id] == text) return id;
+    slot = (slot + 1) & mask;
+  }
+  const uint32_t id = static_cast<uint32_t>(texts->size());
+  texts->push_back(text);
+  slots[slot] = id + 1;
+  return id;
+}
+
+void ProcessTableBuilder::Build(const vector<ProcessSnapshot>& processes,
+                                ProcessTable& table) {
+  const size_t size = processes.size();
+  table.pid.resize(size);
+  table.user.resize(size);
+  table.command.resize(size);
+  table.parent.resize(size);
+  table.cpu.resize(size);
+  table.rss.resize(size);
+  table.vsz.resize(size);
+  users.Reset(size, table.users);
+  commands.Reset(size, table.commands);
+
+  for (size_t i = 0; i < size; ++i) {
+    const ProcessSnapshot& process = processes[i];
+    table.pid[i] = process.pid;
+    table.user[i] = users.Id(process.user);
+    table.command[i] = commands.Id(process.command);
+    table.cpu[i] = process.cpu_utilization;
+    table.rss[i] = process.rss;
+    table.vsz[i] = process.vsz;
+  }
+  for (size_t i = 0; i < size; ++i) {
+    auto parent = std::lower_bound(table.pid.begin(), table.pid.end(),
+                                   processes[i].ppid);
+    table.parent[i] = parent != table.pid.end() && *parent == processes[i].ppid
+                          ? static_cast<uint32_t>(parent - table.pid.begin())
+                          : ProcessTable::kNoParent;
+  }
+}
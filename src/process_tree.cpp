@@ -0,0 +1,202 @@
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "process_tree.h"
+
+using std::size_t;
+using std::vector;
+
+uint32_t ProcessTree::Create(const ProcessSnapshot& process, uint32_t row) {
+  uint32_t id;
+  if (unused.empty()) {
+    id = static_cast<uint32_t>(nodes.size());
+    nodes.emplace_back();
+  } else {
+    id = unused.back();
+    unused.pop_back();
+    nodes[id] = Node();
+  }
+  Node& node = nodes[id];
+  node.pid = process.pid;
+  node.ppid = process.ppid;
+  node.starttime = process.starttime;
+  node.row = row;
+  node.cpu = process.cpu_utilization;
+  node.rss = process.rss;
+  node.subtree_cpu = node.cpu;
+  node.subtree_rss = node.rss;
+  return id;
+}
+
+// Children of a gone process wait under the root until the snapshot
+// shows who adopted them, or their parent is back (see Update)
+void ProcessTree::Remove(uint32_t id) {
+  Detach(id);
+  while (nodes[id].first_child != kNone) {
+    const uint32_t child = nodes[id].first_child;
+    Detach(child);
+    Attach(child, kRoot);
+  }
+  unused.push_back(id);
+}
+
+uint32_t ProcessTree::Find(int pid) const {
+  auto found = std::lower_bound(
+      by_pid.begin(), by_pid.end(), pid,
+      [this](uint32_t node, int pid) { return nodes[node].pid < pid; });
+  return found != by_pid.end() && nodes[*found].pid == pid ? *found : kRoot;
+}
+
+void ProcessTree::Attach(uint32_t id, uint32_t parent) {
+  // A parent inside the node's own subtree would close a loop
+  for (uint32_t above = parent; above != kNone; above = nodes[above].parent) {
+    if (above == id) {
+      parent = kRoot;
+      break;
+    }
+  }
+  Node& node = nodes[id];
+  Node& new_parent = nodes[parent];
+  node.parent = parent;
+  node.previous = new_parent.last_child;
+  node.next = kNone;
+  if (new_parent.last_child == kNone) {
+    new_parent.first_child = id;
+  } else {
+    nodes[new_parent.last_child].next = id;
+  }
+  new_parent.last_child = id;
+  Propagate(parent, node.subtree_cpu, node.subtree_rss);
+}
+
+void ProcessTree::Detach(uint32_t id) {
+  Node& node = nodes[id];
+  if (node.parent == kNone) return;
+  Propagate(node.parent, -node.subtree_cpu, -node.subtree_rss);
+  Node& parent = nodes[node.parent];
+  if (node.previous == kNone) {
+    parent.first_child = node.next;
+  } else {
+    nodes[node.previous].next = node.next;
+  }
+  if (node.next == kNone) {
+    parent.last_child = node.previous;
+  } else {
+    nodes[node.next].previous = node.previous;
+  }
+  node.parent = node.previous = node.next = kNone;
+}
+
+void ProcessTree::Propagate(uint32_t id, double cpu, int64_t rss) {
+  for (; id != kNone; id = nodes[id].parent) {
+    nodes[id].subtree_cpu += cpu;
+    nodes[id].subtree_rss += rss;
+  }
+}
+
+// One merge of the old and new PID lists finds what appeared, vanished
+// or moved; new and moved processes are linked once every node exists,
+// since a parent can have a larger PID than its child
+void ProcessTree::Update(const vector<ProcessSnapshot>& input_processes) {
+  processes = &input_processes;
+  if (nodes.empty()) nodes.emplace_back();
+  next_by_pid.clear();
+  added.clear();
+  moved.clear();
+
+  size_t old = 0;
+  for (size_t i = 0; i < input_processes.size(); ++i) {
+    const ProcessSnapshot& process = input_processes[i];
+    const uint32_t row = static_cast<uint32_t>(i);
+    while (old < by_pid.size() && nodes[by_pid[old]].pid < process.pid) {
+      Remove(by_pid[old++]);
+    }
+    uint32_t id = kNone;
+    if (old < by_pid.size() && nodes[by_pid[old]].pid == process.pid) {
+      id = by_pid[old++];
+      // A recycled PID is a different process
+      if (nodes[id].starttime != process.starttime) {
+        Remove(id);
+        id = kNone;
+      }
+    }
+    if (id == kNone) {
+      id = Create(process, row);
+      added.push_back(id);
+      next_by_pid.push_back(id);
+      continue;
+    }
+
+    if (nodes[id].ppid != process.ppid) {
+      // Unlinked now, so the ancestors lose exactly what they were given
+      Detach(id);
+      nodes[id].ppid = process.ppid;
+      moved.push_back(id);
+    }
+    Node& node = nodes[id];
+    node.row = row;
+    const double cpu = process.cpu_utilization - node.cpu;
+    const int64_t rss = process.rss - node.rss;
+    node.cpu = process.cpu_utilization;
+    node.rss = process.rss;
+    if (cpu != 0 || rss != 0) Propagate(id, cpu, rss);
+    next_by_pid.push_back(id);
+  }
+  while (old < by_pid.size()) Remove(by_pid[old++]);
+  std::swap(by_pid, next_by_pid);
+
+  for (uint32_t id : moved) Attach(id, Find(nodes[id].ppid));
+  for (uint32_t id : added) Attach(id, Find(nodes[id].ppid));
+  if (added.empty()) return;
+  // A filter can leave a parent out of the snapshot while it lives on and
+  // its children keep their ppid; when it comes back it takes them again
+  // Attach puts a node that would close a loop back at the end of the
+  // root's children, so the walk stops at the last one it started with
+  const uint32_t last = nodes[kRoot].last_child;
+  for (uint32_t id = nodes[kRoot].first_child; id != kNone;) {
+    const uint32_t next = id == last ? kNone : nodes[id].next;
+    const uint32_t parent = Find(nodes[id].ppid);
+    if (parent != kRoot) {
+      Detach(id);
+      Attach(id, parent);
+    }
+    id = next;
+  }
+}
+
+const vector<ProcessTree::Row>& ProcessTree::Rows() {
+  rows.clear();
+  stack.clear();
+  if (nodes.empty() || processes == nullptr) return rows;
+  int depth = 0;
+  uint32_t id = nodes[kRoot].first_child;
+  while (id != kNone) {
+    const Node& node = nodes[id];
+    const bool parent = node.first_child != kNone;
+    rows.push_back({&(*processes)[node.row], depth, node.subtree_cpu,
+                    node.subtree_rss, parent, node.collapsed});
+    if (parent && !node.collapsed) {
+      stack.push_back(id);
+      id = node.first_child;
+      ++depth;
+      continue;
+    }
+    while (nodes[id].next == kNone && !stack.empty()) {
+      id = stack.back();
+      stack.pop_back();
+      --depth;
+    }
+    id = nodes[id].next;
+  }
+  return rows;
+}
+
+void ProcessTree::Collapse(int pid, bool collapsed) {
+  const uint32_t id = Find(pid);
+  if (id != kRoot) nodes[id].collapsed = collapsed;
+}
+
+size_t ProcessTree::Size() const { return by_pid.size(); }
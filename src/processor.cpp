@@ -1,20 +1,61 @@
-#include <chrono>
-#include <thread>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
 
 #include "linux_parser.h"
 #include "processor.h"
 
-// Return the aggregate CPU utilization
-float Processor::Utilization() {
-  float initial_total = LinuxParser::Jiffies();
-  float initial_idle = LinuxParser::IdleJiffies();
-  float final_total = 0, final_idle = 0, delta_total;
+// Feed the counters of the current tick
+// The first sample is compared with zero, i.e. the average since boot
+void Processor::Update(const LinuxParser::CpuTimes& times) {
+  // iowait is allowed to go backwards, so work with signed deltas
+  const long long delta_total =
+      static_cast<long long>(times.Total() - previous.Total());
+  const long long delta_idle =
+      static_cast<long long>(times.Idle() - previous.Idle());
 
-  std::this_thread::sleep_for(std::chrono::milliseconds(300));
+  if (delta_total > 0) {
+    utilization = std::clamp(
+        1 - static_cast<float>(delta_idle) / delta_total, 0.0f, 1.0f);
+  }
+  previous = times;
+}
 
-  final_total = LinuxParser::Jiffies();
-  final_idle = LinuxParser::IdleJiffies();
-  delta_total = final_total - initial_total;
+// Same for every core at once
+void Processor::Update(const LinuxParser::CoreTimes& times) {
+  const std::size_t count = times.Size();
+  cores.resize(count);
+  if (previous_total.size() != count) {
+    // First tick or cores went on/offline: average since boot, which can
+    // overflow the 32 bit deltas below
+    for (std::size_t i = 0; i < count; ++i) {
+      const float total = std::max<float>(times.total[i], 1);
+      cores[i] = std::clamp(times.busy[i] / total, 0.0f, 1.0f);
+    }
+  } else {
+    // A tick is far below 2^31 jiffies, so 32 bit signed deltas are exact
+    // and convert to float in one packed instruction; without branches
+    // the compiler turns this loop into SIMD code
+    const uint64_t* busy = times.busy.data();
+    const uint64_t* total = times.total.data();
+    const uint64_t* old_busy = previous_busy.data();
+    const uint64_t* old_total = previous_total.data();
+    float* result = cores.data();
+    for (std::size_t i = 0; i < count; ++i) {
+      const float busy_delta =
+          static_cast<float>(static_cast<int32_t>(busy[i] - old_busy[i]));
+      const float total_delta =
+          static_cast<float>(static_cast<int32_t>(total[i] - old_total[i]));
+      const float ratio = busy_delta / std::max(total_delta, 1.0f);
+      result[i] = std::min(std::max(ratio, 0.0f), 1.0f);
+    }
+  }
+  previous_busy.assign(times.busy.begin(), times.busy.end());
+  previous_total.assign(times.total.begin(), times.total.end());
+}
 
-  return delta_total == 0 ? delta_total : (final_idle - initial_idle)/delta_total;
-}
\ No newline at end of file
+// Return the aggregate CPU utilization over the last tick
+float Processor::Utilization() const { return utilization; }
+
+const std::vector<float>& Processor::CoreUtilization() const { return cores; }
@@ -0,0 +1,28 @@
+#include <signal.h>
+#include <cerrno>
+#include <cstdint>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+#include "proc_reader.h"
+#include "publication.h"
+
+// The PID is one of this machine, so the real /proc is read even when
+// sampling reads another root
+int64_t Publication::StartTime(int64_t pid) {
+  std::ifstream stream("/proc/" + std::to_string(pid) + "/stat");
+  const std::string content{std::istreambuf_iterator<char>(stream),
+                            std::istreambuf_iterator<char>()};
+  PidStat stat;
+  if (content.empty() || !ProcParse::Stat(content, stat)) return -1;
+  return stat.starttime;
+}
+
+bool Publication::Running(int64_t pid, int64_t start) {
+  if (pid <= 0) return false;
+  const int64_t started = StartTime(pid);
+  if (started >= 0) return started == start;
+  // Without access to its stat, e.g. under hidepid, only the PID is known
+  return kill(pid, 0) == 0 || errno == EPERM;
+}
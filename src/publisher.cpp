@@ -0,0 +1,131 @@
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include "publisher.h"
+#include "recording.h"
+
+using Publication::Header;
+using Publication::Slot;
+using std::string;
+
+namespace {
+std::runtime_error Failure(const string& what, const string& name) {
+  return std::runtime_error(what + " " + name + ": " + std::strerror(errno));
+}
+
+// PID of the live publisher of an existing segment, 0 for none
+int64_t Owner(const string& name) {
+  const int fd = shm_open(name.c_str(), O_RDONLY | O_CLOEXEC, 0);
+  if (fd < 0) return 0;
+  struct stat segment;
+  void* mapping = MAP_FAILED;
+  if (fstat(fd, &segment) == 0 &&
+      static_cast<size_t>(segment.st_size) >= sizeof(Header)) {
+    mapping = mmap(nullptr, sizeof(Header), PROT_READ, MAP_SHARED, fd, 0);
+  }
+  close(fd);
+  if (mapping == MAP_FAILED) return 0;
+  const Header* header = static_cast<const Header*>(mapping);
+  int64_t owner = 0;
+  if (std::memcmp(header->magic, Publication::kMagic, sizeof(header->magic)) ==
+          0 &&
+      Publication::Running(header->publisher, header->publisher_start)) {
+    owner = header->publisher;
+  }
+  munmap(mapping, sizeof(Header));
+  return owner;
+}
+}  // namespace
+
+Publisher::Publisher(const string& input_name, std::size_t capacity)
+    : name("/" + input_name) {
+  const uint64_t slot_capacity =
+      capacity / Publication::kSlots & ~(Publication::kAlignment - 1);
+  if (slot_capacity == 0) {
+    throw std::runtime_error("segment size too small: " + name);
+  }
+  length = Publication::HeaderSize() + Publication::kSlots * slot_capacity;
+
+  // A segment left behind by a publisher that died is taken over
+  int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+  if (fd < 0 && errno == EEXIST) {
+    const int64_t owner = Owner(name);
+    if (owner != 0) {
+      throw std::runtime_error(name + " is published by PID " +
+                               std::to_string(owner));
+    }
+    shm_unlink(name.c_str());
+    fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+  }
+  if (fd < 0) throw Failure("cannot create", name);
+  // Viewers may run as other users; the umask would hide it from them
+  if (fchmod(fd, 0644) != 0 || ftruncate(fd, length) != 0) {
+    close(fd);
+    shm_unlink(name.c_str());
+    throw Failure("cannot size", name);
+  }
+  void* mapping =
+      mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (mapping == MAP_FAILED) {
+    shm_unlink(name.c_str());
+    throw Failure("cannot map", name);
+  }
+
+  // The new segment is zero filled, which is also what the atomics start
+  // at; the magic goes in last so nobody reads a half written header
+  header = static_cast<Header*>(mapping);
+  header->version = Publication::kVersion;
+  header->codec_version = Recording::kVersion;
+  header->header_size = Publication::HeaderSize();
+  header->capacity = slot_capacity;
+  header->publisher = getpid();
+  header->publisher_start = Publication::StartTime(header->publisher);
+  std::atomic_thread_fence(std::memory_order_release);
+  std::memcpy(header->magic, Publication::kMagic, sizeof(header->magic));
+}
+
+// Viewers keep their mapping; only the name goes away
+Publisher::~Publisher() {
+  if (!header) return;
+  munmap(header, length);
+  shm_unlink(name.c_str());
+}
+
+// The slot after the newest is written while readers look at the newest,
+// then becomes the newest itself
+void Publisher::Publish(const SystemSnapshot& snapshot) {
+  payload.clear();
+  encoder.Encode(snapshot, true, payload);
+  if (payload.size() > header->capacity) {
+    if (!warned) {
+      std::fprintf(stderr, "snapshot of %zu bytes does not fit %s, skipped\n",
+                   payload.size(), name.c_str());
+      warned = true;
+    }
+    return;
+  }
+
+  const uint64_t next = header->latest.load(std::memory_order_relaxed) + 1;
+  const std::size_t index = next % Publication::kSlots;
+  Slot& slot = header->slots[index];
+  slot.sequence.fetch_add(1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  std::memcpy(reinterpret_cast<uint8_t*>(header) +
+                  Publication::Offset(header->header_size, header->capacity,
+                                      index),
+              payload.data(), payload.size());
+  slot.size = payload.size();
+  slot.tick = snapshot.tick;
+  slot.timestamp_ms = snapshot.timestamp_ms;
+  slot.sequence.fetch_add(1, std::memory_order_release);
+  header->latest.store(next, std::memory_order_release);
+}
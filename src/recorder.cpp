@@ -0,0 +1,130 @@
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include "recorder.h"
+
+#define KEYFRAME_INTERVAL 64
+#define NO_ROOM static_cast<uint64_t>(-1)
+
+using Recording::FileHeader;
+using Recording::RecordHeader;
+using std::string;
+
+namespace {
+std::runtime_error Failure(const string& what, const string& path) {
+  return std::runtime_error(what + " " + path + ": " + std::strerror(errno));
+}
+}  // namespace
+
+Recorder::Recorder(const string& path, std::size_t capacity)
+    : length(sizeof(FileHeader) + (capacity & ~(Recording::kAlignment - 1))) {
+  if (capacity < Recording::Span(0) * 2) {
+    throw std::runtime_error("recording size too small: " + path);
+  }
+  int fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (fd < 0) throw Failure("cannot create", path);
+  if (ftruncate(fd, length) != 0) {
+    close(fd);
+    throw Failure("cannot size", path);
+  }
+  void* mapping = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED,
+                       fd, 0);
+  close(fd);
+  if (mapping == MAP_FAILED) throw Failure("cannot map", path);
+
+  header = static_cast<FileHeader*>(mapping);
+  std::memcpy(header->magic, Recording::kMagic, sizeof(header->magic));
+  header->version = Recording::kVersion;
+  header->header_size = sizeof(FileHeader);
+  header->capacity = length - sizeof(FileHeader);
+  header->head = 0;
+  header->tail = 0;
+  header->records = 0;
+}
+
+Recorder::~Recorder() {
+  if (header) munmap(header, length);
+}
+
+uint8_t* Recorder::Ring(uint64_t offset) const {
+  return reinterpret_cast<uint8_t*>(header) + sizeof(FileHeader) + offset;
+}
+
+// Drop the oldest record and move the tail past it, and past a wrap
+void Recorder::Evict() {
+  RecordHeader record;
+  std::memcpy(&record, Ring(header->tail), sizeof(record));
+  header->tail += Recording::Span(record.size);
+  --header->records;
+  if (record.flags & Recording::kKeyframe) --keyframes;
+  if (header->records == 0) {
+    header->tail = header->head;
+    return;
+  }
+  if (header->capacity - header->tail < sizeof(RecordHeader)) {
+    header->tail = 0;
+    return;
+  }
+  std::memcpy(&record, Ring(header->tail), sizeof(record));
+  if (record.flags & Recording::kWrap) header->tail = 0;
+}
+
+void Recorder::Append(const SystemSnapshot& snapshot) {
+  keyframe = keyframe || since_keyframe >= KEYFRAME_INTERVAL;
+  payload.clear();
+  encoder.Encode(snapshot, keyframe, payload);
+  uint64_t head = Reserve(Recording::Span(payload.size()));
+  if (!keyframe && keyframes == 0) {
+    // The last keyframe was overwritten, so nothing left in the ring
+    // could be decoded; this record has to become one
+    keyframe = true;
+    payload.clear();
+    encoder.Encode(snapshot, keyframe, payload);
+    head = Reserve(Recording::Span(payload.size()));
+  }
+  if (head == NO_ROOM) {
+    // Dropped; the next record has to stand on its own
+    keyframe = true;
+    return;
+  }
+
+  RecordHeader record{static_cast<uint32_t>(payload.size()),
+                      keyframe ? Recording::kKeyframe : 0u, snapshot.tick,
+                      snapshot.timestamp_ms};
+  std::memcpy(Ring(head), &record, sizeof(record));
+  std::memcpy(Ring(head) + sizeof(record), payload.data(), payload.size());
+  // Publish the record only once its bytes are in place
+  header->head = head + Recording::Span(record.size);
+  ++header->records;
+  if (keyframe) ++keyframes;
+
+  since_keyframe = keyframe ? 1 : since_keyframe + 1;
+  keyframe = false;
+}
+
+// Evict the records in the way of span bytes at the head and return the
+// offset to write them to, wrapping to the start of the ring if needed
+uint64_t Recorder::Reserve(uint64_t span) {
+  if (span > header->capacity) return NO_ROOM;
+  uint64_t head = header->head;
+  if (head + span > header->capacity) {
+    // Everything between the head and the end of the ring is lost
+    while (header->records > 0 && header->tail >= head) Evict();
+    if (header->capacity - head >= sizeof(RecordHeader)) {
+      RecordHeader wrap{0, Recording::kWrap, 0, 0};
+      std::memcpy(Ring(head), &wrap, sizeof(wrap));
+    }
+    head = header->head = 0;
+    if (header->records == 0) header->tail = 0;
+  }
+  while (header->records > 0 && header->tail >= head &&
+         header->tail < head + span) {
+    Evict();
+  }
+  return head;
+}
@@ -0,0 +1,212 @@
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+#include "linux_parser.h"
+#include "refresh_schedule.h"
+
+// Idle processes are read at least every 2^MAX_LEVEL ticks
+#define MAX_LEVEL 6
+// A process rejected for good only after this long, since a fresh child
+// usually execs or drops to its user's uid right after the fork
+#define HIDE_AFTER_SECONDS 5
+// Back off only once a tick costs less than a third of the budget, so
+// halving the period again does not overrun it straight away
+#define RELAX_FACTOR 3
+
+using LinuxParser::kAllFields;
+using LinuxParser::kCommandFields;
+using LinuxParser::kMemoryFields;
+using LinuxParser::kSmapsFields;
+using LinuxParser::kStatFields;
+using LinuxParser::kStatusFields;
+using std::size_t;
+using std::vector;
+
+RefreshSchedule::RefreshSchedule(Settings input_settings)
+    : settings(input_settings) {}
+
+// Both lists are sorted, so one merge pass carries every known process
+// over to its new position
+void RefreshSchedule::Begin(const vector<int>& pids, long input_uptime) {
+  ++tick;
+  uptime = input_uptime;
+  if (spare.size() < pids.size()) spare.resize(pids.size());
+  size_t known = 0;
+  auto forget = [this](Slot& slot) {
+    commands.Release(slot.command.id);
+    slot.command = {};
+  };
+  for (size_t i = 0; i < pids.size(); ++i) {
+    while (known < count && slots[known].process.pid < pids[i]) {
+      forget(slots[known++]);
+    }
+    Slot& slot = spare[i];
+    if (known < count && slots[known].process.pid == pids[i]) {
+      std::swap(slot, slots[known++]);
+    } else {
+      slot.process.pid = pids[i];
+      slot.command = {};
+      slot.unread = kAllFields;
+      slot.busy = false;
+      slot.hidden = false;
+    }
+    slot.visible =
+        std::binary_search(visible.begin(), visible.end(), pids[i]);
+  }
+  while (known < count) forget(slots[known++]);
+  std::swap(slots, spare);
+  count = pids.size();
+}
+
+void RefreshSchedule::Invalidate(int pid) {
+  auto slot = std::lower_bound(
+      slots.begin(), slots.begin() + count, pid,
+      [](const Slot& slot, int pid) { return slot.process.pid < pid; });
+  if (slot != slots.begin() + count && slot->process.pid == pid) {
+    slot->unread = kAllFields;
+    slot->hidden = false;
+  }
+}
+
+void RefreshSchedule::Prioritize(const vector<int>& pids) {
+  visible.assign(pids.begin(), pids.end());
+  std::sort(visible.begin(), visible.end());
+}
+
+// Idle processes are spread over the period by PID, so every tick reads
+// about the same share of them. Only processes on screen have their
+// smaps_rollup read.
+unsigned RefreshSchedule::Due(size_t i) const {
+  const Slot& slot = slots[i];
+  const unsigned smaps = slot.visible ? kSmapsFields : 0u;
+  if (slot.unread == kAllFields) return kAllFields | smaps;
+  const unsigned long phase = tick + slot.process.pid;
+  // Only stat, which shows an exec through Missing; the rest stays
+  // unread until the process matches
+  if (slot.hidden) return phase % Period() == 0 ? kStatFields : 0u;
+  const bool priority = slot.busy || slot.visible;
+  if (!priority && phase % Period() != 0) return slot.unread;
+  if (priority || phase % (settings.memory_interval * Period()) == 0) {
+    return kStatFields | kMemoryFields | smaps | slot.unread;
+  }
+  return kStatFields | slot.unread;
+}
+
+unsigned RefreshSchedule::Missing(size_t i, const ProcessSnapshot& snapshot,
+                                  unsigned fields) const {
+  const ProcessSnapshot& known = slots[i].process;
+  if (!(fields & kStatFields) || (known.starttime == snapshot.starttime &&
+                                  known.name == snapshot.name)) {
+    return 0;
+  }
+  return kAllFields & ~fields;
+}
+
+void RefreshSchedule::Merge(size_t i, unsigned fields,
+                            ProcessSnapshot& snapshot) {
+  Slot& slot = slots[i];
+  ProcessSnapshot& known = slot.process;
+  snapshot.pid = known.pid;
+  if (fields & kStatFields) {
+    // A reused PID must not show the previous process's smaps
+    if (known.starttime != snapshot.starttime) known.pss = known.uss = -1;
+    // An exec may make it match; the filter decides again
+    if (known.starttime != snapshot.starttime ||
+        known.name != snapshot.name) {
+      slot.hidden = false;
+    }
+    known.name.assign(snapshot.name);
+    known.state = snapshot.state;
+    known.ppid = snapshot.ppid;
+    known.utime = snapshot.utime;
+    known.stime = snapshot.stime;
+    known.starttime = snapshot.starttime;
+  } else {
+    static const long hertz = sysconf(_SC_CLK_TCK);
+    const long start_second = known.starttime / hertz;
+    snapshot.name.assign(known.name);
+    snapshot.state = known.state;
+    snapshot.ppid = known.ppid;
+    snapshot.utime = known.utime;
+    snapshot.stime = known.stime;
+    snapshot.starttime = known.starttime;
+    snapshot.uptime = uptime > start_second ? uptime - start_second : 0;
+    snapshot.cpu_utilization = known.cpu_utilization;
+  }
+  if (fields & kMemoryFields) {
+    known.vsz = snapshot.vsz;
+    known.rss = snapshot.rss;
+    known.shared = snapshot.shared;
+  } else {
+    snapshot.vsz = known.vsz;
+    snapshot.rss = known.rss;
+    snapshot.shared = known.shared;
+  }
+  // Kept from the last time the process was on screen
+  if (fields & kSmapsFields) {
+    known.pss = snapshot.pss;
+    known.uss = snapshot.uss;
+  } else {
+    snapshot.pss = known.pss;
+    snapshot.uss = known.uss;
+  }
+  if (fields & kStatusFields) {
+    known.uid = snapshot.uid;
+  } else {
+    snapshot.uid = known.uid;
+  }
+  if (fields & kCommandFields) {
+    const StringPool::Entry previous = slot.command;
+    slot.command = commands.Intern(snapshot.command);
+    commands.Release(previous.id);
+    known.command = slot.command.text;
+  }
+  snapshot.command = known.command;
+  slot.unread &= ~fields;
+}
+
+void RefreshSchedule::Skip(size_t i, unsigned fields) {
+  slots[i].unread |= fields & kAllFields;
+}
+
+unsigned RefreshSchedule::Known(size_t i) const {
+  return kAllFields & ~slots[i].unread;
+}
+
+void RefreshSchedule::Hide(size_t i) {
+  static const long hertz = sysconf(_SC_CLK_TCK);
+  Slot& slot = slots[i];
+  if (uptime - slot.process.starttime / hertz >= HIDE_AFTER_SECONDS) {
+    slot.hidden = true;
+  }
+}
+
+void RefreshSchedule::ShowAll() {
+  for (size_t i = 0; i < count; ++i) slots[i].hidden = false;
+}
+
+void RefreshSchedule::Used(size_t i, float cpu_utilization) {
+  slots[i].process.cpu_utilization = cpu_utilization;
+  slots[i].busy = cpu_utilization > 0;
+}
+
+void RefreshSchedule::Finish(std::chrono::nanoseconds used) {
+  if (settings.budget.count() == 0) return;
+  if (used > settings.budget) {
+    level = std::min(level + 1, static_cast<unsigned>(MAX_LEVEL));
+  } else if (level > 0 && used * RELAX_FACTOR < settings.budget) {
+    --level;
+  }
+}
+
+StringPool::Entry RefreshSchedule::Command(size_t i) const {
+  return slots[i].command;
+}
+
+const StringPool& RefreshSchedule::Commands() const { return commands; }
+
+unsigned RefreshSchedule::Period() const { return 1u << level; }
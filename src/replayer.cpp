@@ -0,0 +1,218 @@
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#include "replayer.h"
+
+#define SEEK_TICKS 60
+
+using Recording::FileHeader;
+using Recording::RecordHeader;
+using std::size_t;
+using std::string;
+
+Replayer::Replayer(const string& path) {
+  int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    throw std::runtime_error("cannot open " + path + ": " +
+                             std::strerror(errno));
+  }
+  struct stat file;
+  void* mapping = MAP_FAILED;
+  if (fstat(fd, &file) == 0 &&
+      static_cast<size_t>(file.st_size) >= sizeof(FileHeader)) {
+    length = file.st_size;
+    mapping = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+  }
+  close(fd);
+  if (mapping == MAP_FAILED) {
+    throw std::runtime_error("cannot map " + path);
+  }
+  data = static_cast<const uint8_t*>(mapping);
+
+  FileHeader header;
+  std::memcpy(&header, data, sizeof(header));
+  if (std::memcmp(header.magic, Recording::kMagic, sizeof(header.magic)) !=
+          0 ||
+      header.version != Recording::kVersion ||
+      header.header_size != sizeof(FileHeader) ||
+      header.capacity > length - header.header_size) {
+    munmap(const_cast<uint8_t*>(data), length);
+    throw std::runtime_error("not a recording: " + path);
+  }
+
+  // Index the ring from the oldest record; a replay starts at a keyframe
+  const uint8_t* ring = data + header.header_size;
+  uint64_t offset = header.tail;
+  for (uint64_t i = 0; i < header.records; ++i) {
+    RecordHeader record;
+    if (header.capacity - offset >= sizeof(record)) {
+      std::memcpy(&record, ring + offset, sizeof(record));
+    }
+    if (header.capacity - offset < sizeof(record) ||
+        (record.flags & Recording::kWrap)) {
+      offset = 0;
+      std::memcpy(&record, ring, sizeof(record));
+    }
+    if (Recording::Span(record.size) > header.capacity - offset) break;
+    if (!entries.empty() || (record.flags & Recording::kKeyframe)) {
+      entries.push_back({header.header_size + offset + sizeof(record), record});
+    }
+    offset += Recording::Span(record.size);
+  }
+  if (entries.empty()) {
+    munmap(const_cast<uint8_t*>(data), length);
+    throw std::runtime_error("no complete records in " + path);
+  }
+  Play(0, 0);
+}
+
+Replayer::~Replayer() {
+  if (data) munmap(const_cast<uint8_t*>(data), length);
+}
+
+void Replayer::Start() { Anchor(); }
+
+void Replayer::Stop() { paused = true; }
+
+// Advance to the newest entry whose recorded time has come
+bool Replayer::Update() {
+  if (paused || position + 1 >= entries.size()) return false;
+  const auto elapsed = std::chrono::steady_clock::now() - anchor_time;
+  const long due =
+      entries[position].header.timestamp_ms +
+      std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count();
+  size_t target = position;
+  while (target + 1 < entries.size() &&
+         entries[target + 1].header.timestamp_ms <= due) {
+    ++target;
+  }
+  if (target == position) return false;
+  // Keep the sub-tick remainder so playback does not drift
+  anchor_time += std::chrono::milliseconds(
+      entries[target].header.timestamp_ms - entries[position].header.timestamp_ms);
+  Seek(target);
+  return true;
+}
+
+const SystemSnapshot& Replayer::Latest() const { return snapshot; }
+
+bool Replayer::HandleKey(int key) {
+  const size_t last = entries.size() - 1;
+  switch (key) {
+    case ' ':
+      paused = !paused;
+      break;
+    case '.':
+      Seek(std::min(position + 1, last));
+      break;
+    case ',':
+      Seek(position > 0 ? position - 1 : 0);
+      break;
+    case ']':
+      Seek(std::min(position + SEEK_TICKS, last));
+      break;
+    case '[':
+      Seek(position > SEEK_TICKS ? position - SEEK_TICKS : 0);
+      break;
+    case 'g':
+      Seek(0);
+      break;
+    case 'G':
+      Seek(last);
+      break;
+    default:
+      return false;
+  }
+  Anchor();
+  Describe();
+  return true;
+}
+
+std::string_view Replayer::Status() const { return status; }
+
+void Replayer::Anchor() { anchor_time = std::chrono::steady_clock::now(); }
+
+// Going forward applies the deltas in between; going back restarts at
+// the keyframe before target
+void Replayer::Seek(size_t target) {
+  if (target == position) return;
+  size_t index = position + 1;
+  if (target < position ||
+      std::any_of(entries.begin() + position + 1, entries.begin() + target + 1,
+                  [](const Entry& entry) {
+                    return entry.header.flags & Recording::kKeyframe;
+                  })) {
+    index = Keyframe(target);
+  }
+  Play(index, target);
+}
+
+// Decode entries from through target, from being a keyframe or the entry
+// after position. A record that does not decode, e.g. one overwritten
+// while it was written, leaves the snapshot half updated: it is dropped
+// with the deltas that depend on it, and the snapshot is rebuilt from a
+// keyframe up to the entry before them.
+void Replayer::Play(size_t from, size_t target) {
+  while (from <= target) {
+    if (Decode(from)) {
+      ++from;
+      continue;
+    }
+    Drop(from);
+    target = std::min(from > 0 ? from - 1 : 0, entries.size() - 1);
+    from = Keyframe(target);
+  }
+  tables.Build(snapshot.processes, snapshot.table);
+  Describe();
+}
+
+size_t Replayer::Keyframe(size_t index) const {
+  while (!(entries[index].header.flags & Recording::kKeyframe)) --index;
+  return index;
+}
+
+void Replayer::Drop(size_t index) {
+  size_t end = index + 1;
+  while (end < entries.size() &&
+         !(entries[end].header.flags & Recording::kKeyframe)) {
+    ++end;
+  }
+  dropped += end - index;
+  entries.erase(entries.begin() + index, entries.begin() + end);
+  if (entries.empty()) {
+    throw std::runtime_error("no readable records in the recording");
+  }
+}
+
+bool Replayer::Decode(size_t index) {
+  const Entry& entry = entries[index];
+  if (!decoder.Decode(data + entry.offset, entry.header.size,
+                      entry.header.flags & Recording::kKeyframe, snapshot)) {
+    return false;
+  }
+  snapshot.tick = entry.header.tick;
+  snapshot.timestamp_ms = entry.header.timestamp_ms;
+  position = index;
+  return true;
+}
+
+void Replayer::Describe() {
+  char line[96];
+  char skipped[48] = "";
+  if (dropped > 0) {
+    std::snprintf(skipped, sizeof(skipped), " %zu unreadable", dropped);
+  }
+  std::snprintf(line, sizeof(line), " REPLAY %zu/%zu%s%s ", position + 1,
+                entries.size(), skipped, paused ? " paused" : "");
+  status = line;
+}
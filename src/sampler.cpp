@@ -0,0 +1,100 @@
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+
+#include "sampler.h"
+
+Sampler::Sampler(System& input_system, std::chrono::milliseconds input_interval)
+    : system(input_system), interval(input_interval) {}
+
+Sampler::~Sampler() { Stop(); }
+
+void Sampler::Start() {
+  if (thread.joinable()) return;
+  Sample();
+  Update();
+  stopping = false;
+  thread = std::thread(&Sampler::Run, this);
+}
+
+void Sampler::Stop() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+  }
+  wake.notify_all();
+  if (thread.joinable()) thread.join();
+}
+
+void Sampler::AddListener(Listener listener) {
+  listeners.push_back(std::move(listener));
+}
+
+void Sampler::Step() {
+  Sample();
+  Update();
+}
+
+bool Sampler::Update() {
+  if (!buffers.Update()) return false;
+  if (Latest().refresh_period != period) {
+    period = Latest().refresh_period;
+    status = period == 1 ? std::string()
+                         : " over budget: idle every " +
+                               std::to_string(period) + " ticks ";
+  }
+  return true;
+}
+
+const SystemSnapshot& Sampler::Latest() const { return buffers.Front(); }
+
+void Sampler::Prioritize(const std::vector<int>& pids) {
+  std::lock_guard<std::mutex> lock(mutex);
+  visible.assign(pids.begin(), pids.end());
+}
+
+bool Sampler::FilterBy(const ProcessFilter& input_filter) {
+  std::lock_guard<std::mutex> lock(mutex);
+  filter = input_filter;
+  filter_changed = true;
+  filter_text = input_filter.Text();
+  return true;
+}
+
+std::string_view Sampler::Filter() const { return filter_text; }
+
+std::string_view Sampler::Status() const { return status; }
+
+void Sampler::Sample() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    system.Prioritize(visible);
+    if (filter_changed) {
+      system.FilterBy(std::move(filter));
+      filter_changed = false;
+    }
+  }
+  system.Refresh();
+  for (const Listener& listener : listeners) {
+    listener(system.Current());
+  }
+  system.Swap(buffers.Back());
+  buffers.Publish();
+}
+
+// Ticks are scheduled on absolute deadlines so slow scans do not drift
+void Sampler::Run() {
+  auto deadline = std::chrono::steady_clock::now() + interval;
+  std::unique_lock<std::mutex> lock(mutex);
+  while (!wake.wait_until(lock, deadline, [this] { return stopping; })) {
+    lock.unlock();
+    Sample();
+    lock.lock();
+    deadline += interval;
+    const auto now = std::chrono::steady_clock::now();
+    if (deadline < now) deadline = now;
+  }
+}
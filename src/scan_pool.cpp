@@ -0,0 +1,78 @@
+#include <algorithm>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+
+#include "scan_pool.h"
+
+// Enough PIDs per chunk to amortise the cursor, small enough to balance
+#define MIN_CHUNK 32
+
+ScanPool::ScanPool(int threads) {
+  for (int i = 1; i < threads; ++i) {
+    workers.emplace_back(&ScanPool::Work, this);
+  }
+}
+
+ScanPool::~ScanPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+  }
+  wake.notify_all();
+  for (std::thread& worker : workers) {
+    worker.join();
+  }
+}
+
+int ScanPool::Size() const { return static_cast<int>(workers.size()) + 1; }
+
+void ScanPool::ForEach(std::size_t input_count, const Task& input_task) {
+  if (workers.empty() || input_count <= MIN_CHUNK) {
+    input_task(0, input_count);
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    task = &input_task;
+    count = input_count;
+    // About four chunks per thread keeps the tail short
+    chunk = std::max<std::size_t>(MIN_CHUNK, count / (4 * Size()));
+    cursor.store(0, std::memory_order_relaxed);
+    busy = static_cast<int>(workers.size());
+    ++generation;
+  }
+  wake.notify_all();
+
+  RunChunks();
+
+  std::unique_lock<std::mutex> lock(mutex);
+  finished.wait(lock, [this] { return busy == 0; });
+  task = nullptr;
+}
+
+void ScanPool::RunChunks() {
+  while (true) {
+    std::size_t begin = cursor.fetch_add(chunk, std::memory_order_relaxed);
+    if (begin >= count) return;
+    (*task)(begin, std::min(begin + chunk, count));
+  }
+}
+
+void ScanPool::Work() {
+  unsigned long seen = 0;
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      wake.wait(lock, [this, seen] { return stopping || generation != seen; });
+      if (stopping) return;
+      seen = generation;
+    }
+    RunChunks();
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      --busy;
+    }
+    finished.notify_one();
+  }
+}
@@ -0,0 +1,443 @@
+#include <unistd.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "snapshot_codec.h"
+
+#define CORE_SCALE 1000
+
+using std::size_t;
+using std::string_view;
+using std::vector;
+
+namespace {
+// Which fields of a process follow its PID
+enum Field : uint32_t {
+  kUid = 1 << 0,
+  kUser = 1 << 1,
+  kCommand = 1 << 2,
+  kVsz = 1 << 3,
+  kRss = 1 << 4,
+  kUtime = 1 << 5,
+  kStime = 1 << 6,
+  kStarttime = 1 << 7,
+  kCpu = 1 << 8,
+  kPpid = 1 << 9,
+  kState = 1 << 10,
+  kShared = 1 << 11,
+  kPss = 1 << 12,
+  kUss = 1 << 13,
+  kName = 1 << 14,
+};
+
+// Which fields of a cgroup follow its mask
+enum CgroupField : uint32_t {
+  kPath = 1 << 0,
+  kProcesses = 1 << 1,
+  kCgroupCpu = 1 << 2,
+  kThrottled = 1 << 3,
+  kMemory = 1 << 4,
+  kAnon = 1 << 5,
+  kFile = 1 << 6,
+  kReadRate = 1 << 7,
+  kWriteRate = 1 << 8,
+};
+
+void PutUnsigned(vector<uint8_t>& output, uint64_t value) {
+  while (value >= 0x80) {
+    output.push_back(static_cast<uint8_t>(value | 0x80));
+    value >>= 7;
+  }
+  output.push_back(static_cast<uint8_t>(value));
+}
+
+// Zigzag keeps small negative differences short
+void PutSigned(vector<uint8_t>& output, int64_t value) {
+  PutUnsigned(output,
+              (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63));
+}
+
+void PutFloat(vector<uint8_t>& output, float value) {
+  uint32_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  for (int i = 0; i < 4; ++i) {
+    output.push_back(static_cast<uint8_t>(bits >> (8 * i)));
+  }
+}
+
+void PutDouble(vector<uint8_t>& output, double value) {
+  uint64_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  for (int i = 0; i < 8; ++i) {
+    output.push_back(static_cast<uint8_t>(bits >> (8 * i)));
+  }
+}
+
+void PutString(vector<uint8_t>& output, string_view text) {
+  PutUnsigned(output, text.size());
+  output.insert(output.end(), text.begin(), text.end());
+}
+
+bool SameFloat(float first, float second) {
+  return std::memcmp(&first, &second, sizeof(float)) == 0;
+}
+
+bool SameDouble(double first, double second) {
+  return std::memcmp(&first, &second, sizeof(double)) == 0;
+}
+
+// Bounds checked reading side; after a failure every read returns 0
+class Input {
+ public:
+  Input(const uint8_t* data, size_t size) : position(data), end(data + size) {}
+
+  uint64_t Unsigned() {
+    uint64_t value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+      if (position == end) return Fail();
+      uint8_t byte = *position++;
+      value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+      if ((byte & 0x80) == 0) return value;
+    }
+    return Fail();
+  }
+  int64_t Signed() {
+    uint64_t value = Unsigned();
+    return static_cast<int64_t>((value >> 1) ^ (~(value & 1) + 1));
+  }
+  float Float() {
+    if (end - position < 4) return Fail();
+    uint32_t bits = 0;
+    for (int i = 0; i < 4; ++i) {
+      bits |= static_cast<uint32_t>(*position++) << (8 * i);
+    }
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+  }
+  double Double() {
+    if (end - position < 8) return Fail();
+    uint64_t bits = 0;
+    for (int i = 0; i < 8; ++i) {
+      bits |= static_cast<uint64_t>(*position++) << (8 * i);
+    }
+    double value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+  }
+  string_view String() {
+    uint64_t size = Unsigned();
+    if (static_cast<uint64_t>(end - position) < size) {
+      Fail();
+      return string_view();
+    }
+    string_view text(reinterpret_cast<const char*>(position), size);
+    position += size;
+    return text;
+  }
+  bool Ok() const { return ok; }
+  bool Done() const { return ok && position == end; }
+
+ private:
+  uint64_t Fail() {
+    ok = false;
+    position = end;
+    return 0;
+  }
+
+  const uint8_t* position;
+  const uint8_t* end;
+  bool ok = true;
+};
+
+uint32_t Differences(const ProcessSnapshot& before,
+                     const ProcessSnapshot& after) {
+  uint32_t mask = 0;
+  if (before.uid != after.uid) mask |= kUid;
+  if (before.user != after.user) mask |= kUser;
+  if (before.command != after.command) mask |= kCommand;
+  if (before.name != after.name) mask |= kName;
+  if (before.vsz != after.vsz) mask |= kVsz;
+  if (before.rss != after.rss) mask |= kRss;
+  if (before.utime != after.utime) mask |= kUtime;
+  if (before.stime != after.stime) mask |= kStime;
+  if (before.starttime != after.starttime) mask |= kStarttime;
+  if (!SameFloat(before.cpu_utilization, after.cpu_utilization)) mask |= kCpu;
+  if (before.ppid != after.ppid) mask |= kPpid;
+  if (before.state != after.state) mask |= kState;
+  if (before.shared != after.shared) mask |= kShared;
+  if (before.pss != after.pss) mask |= kPss;
+  if (before.uss != after.uss) mask |= kUss;
+  return mask;
+}
+
+void PutProcess(vector<uint8_t>& output, const ProcessSnapshot& before,
+                const ProcessSnapshot& after, uint32_t mask) {
+  PutUnsigned(output, mask);
+  if (mask & kUid) PutSigned(output, after.uid - before.uid);
+  if (mask & kUser) PutString(output, after.user);
+  if (mask & kCommand) PutString(output, after.command);
+  if (mask & kName) PutString(output, after.name);
+  if (mask & kVsz) PutSigned(output, after.vsz - before.vsz);
+  if (mask & kRss) PutSigned(output, after.rss - before.rss);
+  if (mask & kUtime) PutSigned(output, after.utime - before.utime);
+  if (mask & kStime) PutSigned(output, after.stime - before.stime);
+  if (mask & kStarttime) PutSigned(output, after.starttime - before.starttime);
+  if (mask & kCpu) PutFloat(output, after.cpu_utilization);
+  if (mask & kPpid) PutSigned(output, after.ppid - before.ppid);
+  if (mask & kState) PutUnsigned(output, static_cast<uint8_t>(after.state));
+  if (mask & kShared) PutSigned(output, after.shared - before.shared);
+  if (mask & kPss) PutSigned(output, after.pss - before.pss);
+  if (mask & kUss) PutSigned(output, after.uss - before.uss);
+}
+
+void GetProcess(Input& input, ProcessSnapshot& process, Arena& strings) {
+  uint32_t mask = static_cast<uint32_t>(input.Unsigned());
+  if (mask & kUid) process.uid += input.Signed();
+  if (mask & kUser) process.user = strings.Copy(input.String());
+  if (mask & kCommand) process.command = strings.Copy(input.String());
+  if (mask & kName) process.name.assign(input.String());
+  if (mask & kVsz) process.vsz += input.Signed();
+  if (mask & kRss) process.rss += input.Signed();
+  if (mask & kUtime) process.utime += input.Signed();
+  if (mask & kStime) process.stime += input.Signed();
+  if (mask & kStarttime) process.starttime += input.Signed();
+  if (mask & kCpu) process.cpu_utilization = input.Float();
+  if (mask & kPpid) process.ppid += static_cast<int>(input.Signed());
+  if (mask & kState) process.state = static_cast<char>(input.Unsigned());
+  if (mask & kShared) process.shared += input.Signed();
+  if (mask & kPss) process.pss += input.Signed();
+  if (mask & kUss) process.uss += input.Signed();
+}
+
+uint32_t Differences(const CgroupSnapshot& before,
+                     const CgroupSnapshot& after) {
+  uint32_t mask = 0;
+  if (before.path != after.path) mask |= kPath;
+  if (before.processes != after.processes) mask |= kProcesses;
+  if (!SameFloat(before.cpu, after.cpu)) mask |= kCgroupCpu;
+  if (!SameFloat(before.throttled, after.throttled)) mask |= kThrottled;
+  if (before.memory != after.memory) mask |= kMemory;
+  if (before.anon != after.anon) mask |= kAnon;
+  if (before.file != after.file) mask |= kFile;
+  if (!SameDouble(before.read_rate, after.read_rate)) mask |= kReadRate;
+  if (!SameDouble(before.write_rate, after.write_rate)) mask |= kWriteRate;
+  return mask;
+}
+
+void PutCgroup(vector<uint8_t>& output, const CgroupSnapshot& before,
+               const CgroupSnapshot& after) {
+  const uint32_t mask = Differences(before, after);
+  PutUnsigned(output, mask);
+  if (mask & kPath) PutString(output, after.path);
+  if (mask & kProcesses) PutSigned(output, after.processes - before.processes);
+  if (mask & kCgroupCpu) PutFloat(output, after.cpu);
+  if (mask & kThrottled) PutFloat(output, after.throttled);
+  if (mask & kMemory) PutSigned(output, after.memory - before.memory);
+  if (mask & kAnon) PutSigned(output, after.anon - before.anon);
+  if (mask & kFile) PutSigned(output, after.file - before.file);
+  if (mask & kReadRate) PutDouble(output, after.read_rate);
+  if (mask & kWriteRate) PutDouble(output, after.write_rate);
+}
+
+void GetCgroup(Input& input, CgroupSnapshot& cgroup) {
+  uint32_t mask = static_cast<uint32_t>(input.Unsigned());
+  if (mask & kPath) cgroup.path.assign(input.String());
+  if (mask & kProcesses) cgroup.processes += static_cast<int>(input.Signed());
+  if (mask & kCgroupCpu) cgroup.cpu = input.Float();
+  if (mask & kThrottled) cgroup.throttled = input.Float();
+  if (mask & kMemory) cgroup.memory += input.Signed();
+  if (mask & kAnon) cgroup.anon += input.Signed();
+  if (mask & kFile) cgroup.file += input.Signed();
+  if (mask & kReadRate) cgroup.read_rate = input.Double();
+  if (mask & kWriteRate) cgroup.write_rate = input.Double();
+}
+
+// A fresh process or cgroup is encoded against these
+const ProcessSnapshot kEmpty{};
+const CgroupSnapshot kEmptyCgroup{};
+
+// The fields of MemorySnapshot in the order they are written
+long MemorySnapshot::*const kMemoryFields[] = {
+    &MemorySnapshot::total,      &MemorySnapshot::available,
+    &MemorySnapshot::free,       &MemorySnapshot::buffers,
+    &MemorySnapshot::cached,     &MemorySnapshot::shared,
+    &MemorySnapshot::swap_total, &MemorySnapshot::swap_free,
+    &MemorySnapshot::huge_total, &MemorySnapshot::huge_free};
+}  // namespace
+
+void SnapshotEncoder::Encode(const SystemSnapshot& snapshot, bool keyframe,
+                             vector<uint8_t>& output) {
+  if (keyframe) {
+    previous.clear();
+    previous_cgroups.clear();
+  }
+
+  PutFloat(output, snapshot.cpu_utilization);
+  PutFloat(output, snapshot.memory_utilization);
+  for (auto field : kMemoryFields) PutSigned(output, snapshot.memory.*field);
+  PutSigned(output, snapshot.uptime);
+  PutSigned(output, snapshot.total_processes);
+  PutSigned(output, snapshot.running_processes);
+  // Per mille is finer than any display of it and fits two bytes
+  PutUnsigned(output, snapshot.core_utilization.size());
+  for (float core : snapshot.core_utilization) {
+    PutUnsigned(output, std::lround(core * CORE_SCALE));
+  }
+  if (keyframe) {
+    PutString(output, snapshot.operating_system);
+    PutString(output, snapshot.kernel);
+    PutUnsigned(output, sysconf(_SC_CLK_TCK));
+  }
+
+  // /proc lists PIDs in ascending order, so sorting is rarely needed
+  const vector<ProcessSnapshot>& processes = snapshot.processes;
+  order.resize(processes.size());
+  for (size_t i = 0; i < order.size(); ++i) order[i] = i;
+  auto by_pid = [&processes](size_t first, size_t second) {
+    return processes[first].pid < processes[second].pid;
+  };
+  if (!std::is_sorted(order.begin(), order.end(), by_pid)) {
+    std::sort(order.begin(), order.end(), by_pid);
+  }
+
+  // Merge the old and new PID lists; PIDs are written as gaps
+  removed.clear();
+  changed.clear();
+  size_t removed_count = 0, changed_count = 0;
+  int last_removed = 0, last_changed = 0;
+  size_t old_index = 0;
+  for (size_t index : order) {
+    const ProcessSnapshot& process = processes[index];
+    while (old_index < previous.size() && previous[old_index].pid < process.pid) {
+      PutUnsigned(removed, previous[old_index].pid - last_removed);
+      last_removed = previous[old_index++].pid;
+      ++removed_count;
+    }
+    const ProcessSnapshot* before = &kEmpty;
+    if (old_index < previous.size() && previous[old_index].pid == process.pid) {
+      before = &previous[old_index++];
+    }
+    uint32_t mask = Differences(*before, process);
+    if (mask == 0 && before != &kEmpty) continue;
+    PutUnsigned(changed, process.pid - last_changed);
+    last_changed = process.pid;
+    PutProcess(changed, *before, process, mask);
+    ++changed_count;
+  }
+  for (; old_index < previous.size(); ++old_index) {
+    PutUnsigned(removed, previous[old_index].pid - last_removed);
+    last_removed = previous[old_index].pid;
+    ++removed_count;
+  }
+
+  PutUnsigned(output, removed_count);
+  output.insert(output.end(), removed.begin(), removed.end());
+  PutUnsigned(output, changed_count);
+  output.insert(output.end(), changed.begin(), changed.end());
+
+  // Cgroups keep their order from tick to tick, so each is encoded
+  // against the one at its index before
+  const vector<CgroupSnapshot>& cgroups = snapshot.cgroups;
+  PutUnsigned(output, cgroups.size());
+  for (size_t i = 0; i < cgroups.size(); ++i) {
+    PutCgroup(output,
+              i < previous_cgroups.size() ? previous_cgroups[i] : kEmptyCgroup,
+              cgroups[i]);
+  }
+  previous_cgroups = cgroups;
+
+  // The snapshot's text may be gone by the next call; keep a copy
+  spare.Reset();
+  previous.resize(processes.size());
+  for (size_t i = 0; i < order.size(); ++i) {
+    ProcessSnapshot& process = previous[i];
+    process = processes[order[i]];
+    process.user = spare.Copy(process.user);
+    process.command = spare.Copy(process.command);
+  }
+  std::swap(strings, spare);
+}
+
+bool SnapshotDecoder::Decode(const uint8_t* data, size_t size, bool keyframe,
+                             SystemSnapshot& snapshot) {
+  Input input(data, size);
+  if (keyframe) {
+    snapshot.processes.clear();
+    snapshot.strings.Reset();
+  }
+
+  snapshot.cpu_utilization = input.Float();
+  snapshot.memory_utilization = input.Float();
+  for (auto field : kMemoryFields) snapshot.memory.*field = input.Signed();
+  snapshot.uptime = input.Signed();
+  snapshot.total_processes = static_cast<int>(input.Signed());
+  snapshot.running_processes = static_cast<int>(input.Signed());
+  const size_t core_count = input.Unsigned();
+  // Every core takes at least a byte, which bounds a corrupt count
+  snapshot.core_utilization.resize(std::min(core_count, size));
+  for (float& core : snapshot.core_utilization) {
+    core = static_cast<float>(input.Unsigned()) / CORE_SCALE;
+  }
+  if (keyframe) {
+    snapshot.operating_system.assign(input.String());
+    snapshot.kernel.assign(input.String());
+    hertz = std::max<long>(1, static_cast<long>(input.Unsigned()));
+  }
+
+  vector<ProcessSnapshot>& current = snapshot.processes;
+  size_t removed_count = input.Unsigned();
+  gone.clear();
+  int pid = 0;
+  for (size_t i = 0; i < removed_count && input.Ok(); ++i) {
+    pid += static_cast<int>(input.Unsigned());
+    gone.push_back(pid);
+  }
+
+  size_t changed_count = input.Unsigned();
+  next.clear();
+  size_t old_index = 0, gone_index = 0;
+  pid = 0;
+  auto keep_until = [&](int limit) {
+    while (old_index < current.size() && current[old_index].pid < limit) {
+      ProcessSnapshot& process = current[old_index++];
+      while (gone_index < gone.size() && gone[gone_index] < process.pid) {
+        ++gone_index;
+      }
+      if (gone_index < gone.size() && gone[gone_index] == process.pid) continue;
+      next.push_back(std::move(process));
+    }
+  };
+  for (size_t i = 0; i < changed_count && input.Ok(); ++i) {
+    pid += static_cast<int>(input.Unsigned());
+    keep_until(pid);
+    if (old_index < current.size() && current[old_index].pid == pid) {
+      next.push_back(std::move(current[old_index++]));
+    } else {
+      next.emplace_back();
+      next.back().pid = pid;
+    }
+    GetProcess(input, next.back(), snapshot.strings);
+  }
+  keep_until(INT32_MAX);
+
+  if (keyframe) snapshot.cgroups.clear();
+  const size_t cgroup_count = input.Unsigned();
+  // Every cgroup takes at least a byte, which bounds a corrupt count
+  snapshot.cgroups.resize(std::min(cgroup_count, size));
+  for (CgroupSnapshot& cgroup : snapshot.cgroups) GetCgroup(input, cgroup);
+  if (!input.Done()) return false;
+
+  current.swap(next);
+  for (ProcessSnapshot& process : current) {
+    const long start_second = process.starttime / hertz;
+    process.uptime =
+        snapshot.uptime > start_second ? snapshot.uptime - start_second : 0;
+  }
+  return true;
+}
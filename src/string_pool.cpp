@@ -0,0 +1,53 @@
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <string_view>
+
+#include "string_pool.h"
+
+using std::size_t;
+using std::string_view;
+
+StringPool::Entry StringPool::Intern(string_view text) {
+  std::lock_guard<std::mutex> lock(mutex);
+  auto found = index.find(text);
+  if (found != index.end()) {
+    Stored& stored = entries[found->second];
+    ++stored.references;
+    return {found->second, stored.text};
+  }
+  Id id;
+  if (unused.empty()) {
+    id = static_cast<Id>(entries.size());
+    entries.push_back({std::string(text), 1});
+  } else {
+    id = unused.back();
+    unused.pop_back();
+    entries[id] = {std::string(text), 1};
+  }
+  // The key views the stored copy, which stays put until it is released
+  const string_view stored = entries[id].text;
+  index.emplace(stored, id);
+  return {id, stored};
+}
+
+void StringPool::Release(Id id) {
+  if (id == kNone) return;
+  std::lock_guard<std::mutex> lock(mutex);
+  Stored& stored = entries[id];
+  if (--stored.references > 0) return;
+  index.erase(stored.text);
+  // Give the memory back; a long command line may never come again
+  std::string().swap(stored.text);
+  unused.push_back(id);
+}
+
+size_t StringPool::Size() const {
+  std::lock_guard<std::mutex> lock(mutex);
+  return index.size();
+}
+
+StringPool::Id StringPool::Limit() const {
+  std::lock_guard<std::mutex> lock(mutex);
+  return static_cast<Id>(entries.size());
+}
@@ -0,0 +1,143 @@
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include "recording.h"
+#include "subscriber.h"
+
+// Decodes of a slot the publisher overwrote before giving up until the
+// next Update; it only happens when a decode takes longer than a tick
+#define READ_ATTEMPTS 3
+// How often to look whether the publisher is still there
+#define CHECK_INTERVAL std::chrono::seconds(1)
+
+using Publication::Header;
+using Publication::Slot;
+using std::string;
+
+namespace {
+bool Running(const Header* header) {
+  return Publication::Running(header->publisher, header->publisher_start);
+}
+}  // namespace
+
+Subscriber::Subscriber(const string& input_name) : name("/" + input_name) {
+  if (!Map()) {
+    throw std::runtime_error("nothing published as " + name);
+  }
+  Read();
+  checked = std::chrono::steady_clock::now();
+  alive = Running(header);
+  status = " ATTACHED " + name + (alive ? " " : ", publisher gone ");
+}
+
+Subscriber::~Subscriber() { Unmap(); }
+
+bool Subscriber::Map() {
+  const int fd = shm_open(name.c_str(), O_RDONLY | O_CLOEXEC, 0);
+  if (fd < 0) return false;
+  struct stat segment;
+  void* mapping = MAP_FAILED;
+  std::size_t size = 0;
+  if (fstat(fd, &segment) == 0 &&
+      static_cast<std::size_t>(segment.st_size) >=
+          Publication::HeaderSize()) {
+    size = segment.st_size;
+    mapping = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+  }
+  close(fd);
+  if (mapping == MAP_FAILED) return false;
+
+  const Header* mapped = static_cast<const Header*>(mapping);
+  if (std::memcmp(mapped->magic, Publication::kMagic, sizeof(mapped->magic)) !=
+          0 ||
+      mapped->version != Publication::kVersion ||
+      mapped->codec_version != Recording::kVersion ||
+      mapped->header_size != Publication::HeaderSize() ||
+      mapped->capacity >
+          (size - mapped->header_size) / Publication::kSlots) {
+    munmap(mapping, size);
+    return false;
+  }
+  std::atomic_thread_fence(std::memory_order_acquire);
+  Unmap();
+  header = mapped;
+  length = size;
+  seen = 0;
+  return true;
+}
+
+void Subscriber::Unmap() {
+  if (header) munmap(const_cast<Header*>(header), length);
+  header = nullptr;
+}
+
+void Subscriber::Start() {}
+
+void Subscriber::Stop() {}
+
+// A change of the status alone also needs a redraw
+bool Subscriber::Update() {
+  const bool changed = Check();
+  if (header->latest.load(std::memory_order_acquire) == seen) return changed;
+  return Read() || changed;
+}
+
+const SystemSnapshot& Subscriber::Latest() const { return snapshot; }
+
+std::string_view Subscriber::Status() const { return status; }
+
+// Decode the newest slot into the spare snapshot and keep it only when
+// the publisher did not touch the slot meanwhile
+bool Subscriber::Read() {
+  for (int attempt = 0; attempt < READ_ATTEMPTS; ++attempt) {
+    const uint64_t latest = header->latest.load(std::memory_order_acquire);
+    if (latest == 0) return false;
+    const std::size_t index = latest % Publication::kSlots;
+    const Slot& slot = header->slots[index];
+    const uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+    if (sequence & 1) continue;
+    const uint64_t size = std::min(slot.size, header->capacity);
+    const uint64_t tick = slot.tick;
+    const int64_t timestamp_ms = slot.timestamp_ms;
+    const bool decoded = decoder.Decode(
+        reinterpret_cast<const uint8_t*>(header) +
+            Publication::Offset(header->header_size, header->capacity, index),
+        size, true, incoming);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (!decoded ||
+        slot.sequence.load(std::memory_order_relaxed) != sequence) {
+      continue;
+    }
+    incoming.tick = tick;
+    incoming.timestamp_ms = timestamp_ms;
+    tables.Build(incoming.processes, incoming.table);
+    std::swap(snapshot, incoming);
+    seen = latest;
+    return true;
+  }
+  return false;
+}
+
+// A publisher that went away may have been replaced by a new one, which
+// creates a new segment under the same name
+bool Subscriber::Check() {
+  const auto now = std::chrono::steady_clock::now();
+  if (now - checked < CHECK_INTERVAL) return false;
+  checked = now;
+  bool running = Running(header);
+  if (!running && Map()) running = Running(header);
+  if (running == alive) return false;
+  alive = running;
+  status = " ATTACHED " + name + (alive ? " " : ", publisher gone ");
+  return true;
+}
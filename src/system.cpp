@@ -1,50 +1,283 @@
+#include <time.h>
 #include <unistd.h>
+#include <algorithm>
+#include <chrono>
 #include <cstddef>
-#include <set>
+#include <memory>
+#include <stdexcept>
 #include <string>
+#include <utility>
 #include <vector>
 
+#include "instrumentation.h"
 #include "linux_parser.h"
+#include "proc_events.h"
 #include "process.h"
 #include "processor.h"
 #include "system.h"
+#include "user_cache.h"
 
-using std::set;
+using LinuxParser::kCommandFields;
+using LinuxParser::kMemoryFields;
+using LinuxParser::kSmapsFields;
+using LinuxParser::kStatFields;
+using LinuxParser::kStatusFields;
 using std::size_t;
 using std::string;
 using std::vector;
 
-// Return the system's CPU
-Processor& System::Cpu() { return cpu; }
+namespace {
+// CPU time of every thread of the monitor so far
+std::chrono::nanoseconds CpuTime() {
+  timespec now{};
+  clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &now);
+  return std::chrono::seconds(now.tv_sec) +
+         std::chrono::nanoseconds(now.tv_nsec);
+}
+}  // namespace
+
+System::System(int threads, bool track_events,
+               RefreshSchedule::Settings schedule_settings)
+    : pool(threads),
+      schedule(schedule_settings),
+      operating_system(LinuxParser::OperatingSystem()),
+      kernel(LinuxParser::Kernel()) {
+  if (!track_events) return;
+  try {
+    events = std::make_unique<ProcEvents>();
+  } catch (const std::runtime_error&) {
+    // Not privileged or no connector: keep scanning /proc every tick
+  }
+}
+
+bool System::TracksEvents() const { return events != nullptr; }
+
+void System::Prioritize(const vector<int>& visible) {
+  schedule.Prioritize(visible);
+}
+
+void System::FilterBy(ProcessFilter input_filter) {
+  filter = std::move(input_filter);
+  schedule.ShowAll();
+}
+
+// With process events the PID list is patched in place; a full scan of
+// /proc is only needed at the start and after events were lost
+void System::UpdatePids() {
+  Instrumentation::ScopedTimer timer(Instrumentation::Phase::kPidScan);
+  if (!events || !events->Poll(pids, stale)) {
+    pids = LinuxParser::Pids();
+  }
+}
+
+// Deduplicated per tick, so workers sharing a command line share the copy
+std::string_view System::StoreCommand(StringPool::Entry command) {
+  if (command.id == StringPool::kNone) return {};
+  if (command.id >= commands.size()) {
+    commands.resize(schedule.Commands().Limit());
+  }
+  Stored& stored = commands[command.id];
+  if (stored.tick != tick) {
+    stored.tick = tick;
+    stored.text = current.strings.Copy(command.text);
+  }
+  return stored.text;
+}
+
+// UserCache keeps one name per uid; the snapshot gets one copy of it
+std::string_view System::StoreUser(int uid) {
+  if (uid < 0) return {};
+  Stored& stored = users[uid];
+  if (stored.tick != tick) {
+    stored.tick = tick;
+    stored.text = current.strings.Copy(UserCache::Instance().Name(uid));
+  }
+  return stored.text;
+}
+
+// A process the filter rejects is never read past the file that
+// rejected it; what it skipped stays due for when it is shown again
+System::Outcome System::ReadFiltered(size_t i, unsigned& fields, long uptime,
+                                     ProcessSnapshot& snapshot) {
+  static constexpr unsigned kCostOrder[] = {
+      kStatFields, kStatusFields, kMemoryFields, kCommandFields, kSmapsFields};
+  unsigned due = fields;
+  unsigned checked = 0;
+  fields = 0;
+  for (unsigned source : kCostOrder) {
+    if (!(due & source)) continue;
+    if (!LinuxParser::ReadProcess(pids[i], uptime, snapshot, source)) {
+      return kGone;
+    }
+    fields |= source;
+    if (source == kStatFields) due |= schedule.Missing(i, snapshot, fields);
+    schedule.Merge(i, fields, snapshot);
+    // Terms on values still to be read this tick wait for them
+    const unsigned current = schedule.Known(i) & ~(due & ~fields);
+    if (!filter.Match(snapshot, current, checked)) {
+      schedule.Skip(i, due & ~fields);
+      if (filter.Lasting()) schedule.Hide(i);
+      return kRejected;
+    }
+  }
+  if (fields == 0) {
+    schedule.Merge(i, 0, snapshot);
+    if (!filter.Match(snapshot, schedule.Known(i), checked)) return kRejected;
+  }
+  return kShown;
+}
 
-// Return a container composed of the system's processes
-vector<Process>& System::Processes() {
-  vector<int> list_pids = LinuxParser::Pids();
-  processes.clear();
+// Sample /proc for the current tick
+// Every process is read at most once here; sorting only looks at the
+// snapshots
+void System::Refresh() {
+  Instrumentation::ScopedTimer timer(Instrumentation::Phase::kRefresh);
+  const std::chrono::nanoseconds start = CpuTime();
+  LinuxParser::Stat(stat);
+  cpu.Update(stat.cpu);
+  cpu.Update(stat.cores);
+  UserCache::Instance().Refresh();
+  filter.Resolve(UserCache::Instance());
 
-  for (long pid : list_pids) {
-    Process process(pid);
-    processes.push_back(process);
+  current.tick = ++tick;
+  // Nothing in this buffer is shown any more; its text goes wholesale
+  current.strings.Reset();
+  current.timestamp_ms =
+      std::chrono::duration_cast<std::chrono::milliseconds>(
+          std::chrono::system_clock::now().time_since_epoch())
+          .count();
+  current.operating_system.assign(operating_system);
+  current.kernel.assign(kernel);
+  current.cpu_utilization = cpu.Utilization();
+  current.core_utilization.assign(cpu.CoreUtilization().begin(),
+                                  cpu.CoreUtilization().end());
+  LinuxParser::Memory(current.memory);
+  current.memory_utilization = LinuxParser::MemoryUtilization(current.memory);
+  current.uptime = LinuxParser::UpTime();
+  current.total_processes = stat.processes;
+  current.running_processes = stat.procs_running;
+
+  UpdatePids();
+  const long uptime = current.uptime;
+  schedule.Begin(pids, uptime);
+  // Exec'd processes show a new command line and maybe a new user
+  for (int pid : stale) schedule.Invalidate(pid);
+  stale.clear();
+  current.refresh_period = schedule.Period();
+
+  // Existing slots keep their strings' capacity across ticks
+  vector<ProcessSnapshot>& snapshots = current.processes;
+  if (snapshots.size() < pids.size()) {
+    snapshots.resize(pids.size());
   }
+  outcomes.assign(pids.size(), kGone);
+  deferred.resize(pids.size());
 
-  std::sort(processes.rbegin(), processes.rend());
-  return processes;
+  // Every thread writes only the slots of the chunks it claimed
+  {
+    Instrumentation::ScopedTimer timer(Instrumentation::Phase::kParse);
+    pool.ForEach(pids.size(), [this, &snapshots, uptime](size_t begin,
+                                                         size_t end) {
+      for (size_t i = begin; i < end; ++i) {
+        ProcessSnapshot& snapshot = snapshots[i];
+        unsigned fields = schedule.Due(i);
+        if (!(fields & kStatFields)) {
+          Instrumentation::Add(Instrumentation::Counter::kDeferred);
+        }
+        if (!filter.Empty()) {
+          outcomes[i] = ReadFiltered(i, fields, uptime, snapshot);
+          deferred[i] = !(fields & kStatFields);
+          continue;
+        }
+        if (fields != 0 &&
+            !LinuxParser::ReadProcess(pids[i], uptime, snapshot, fields)) {
+          continue;
+        }
+        const unsigned missing = schedule.Missing(i, snapshot, fields);
+        if (missing != 0 &&
+            LinuxParser::ReadProcess(pids[i], uptime, snapshot, missing)) {
+          fields |= missing;
+        }
+        schedule.Merge(i, fields, snapshot);
+        deferred[i] = !(fields & kStatFields);
+        outcomes[i] = kShown;
+      }
+    });
+  }
+
+  // Close the gaps left by exited and rejected processes in PID order, so
+  // the result matches a serial scan; swapping keeps every slot's buffers
+  // alive. Rejected processes stay in the PID list.
+  size_t count = 0;
+  size_t alive = 0;
+  {
+    Instrumentation::ScopedTimer timer(Instrumentation::Phase::kAccounting);
+    accounting.Begin(std::chrono::steady_clock::now());
+    for (size_t i = 0; i < pids.size(); ++i) {
+      if (outcomes[i] == kGone) continue;
+      pids[alive++] = pids[i];
+      if (outcomes[i] == kRejected) continue;
+      ProcessSnapshot& snapshot = snapshots[i];
+      snapshot.command = StoreCommand(schedule.Command(i));
+      if (deferred[i]) {
+        accounting.Keep(snapshot);
+      } else {
+        accounting.Update(snapshot);
+        schedule.Used(i, snapshot.cpu_utilization);
+      }
+      // CPU terms need this tick's share, so they come last
+      unsigned checked = 0;
+      if (!filter.Match(snapshot, ProcessFilter::kUsage, checked)) continue;
+      if (i != count) std::swap(snapshots[count], snapshots[i]);
+      ++count;
+    }
+    accounting.Sweep();
+  }
+  snapshots.resize(count);
+  {
+    Instrumentation::ScopedTimer timer(Instrumentation::Phase::kUsers);
+    for (ProcessSnapshot& snapshot : snapshots) {
+      snapshot.user = StoreUser(snapshot.uid);
+    }
+  }
+  // Reaped processes leave the list kept up to date by events
+  pids.resize(alive);
+  tables.Build(snapshots, current.table);
+  {
+    Instrumentation::ScopedTimer timer(Instrumentation::Phase::kCgroups);
+    cgroup_stats.Refresh(snapshots, pool, current.cgroups);
+  }
+  schedule.Finish(CpuTime() - start);
 }
 
+void System::Swap(SystemSnapshot& other) { std::swap(current, other); }
+
+const SystemSnapshot& System::Current() const { return current; }
+
+// Return the system's CPU
+Processor& System::Cpu() { return cpu; }
+
+// Return the n first processes in the current sort order
+vector<Process>& System::Processes(size_t n) { return top.Select(current, n); }
+
+void System::SortBy(SortKey key) { top.SortBy(key); }
+
+SortKey System::Sorting() const { return top.Sorting(); }
+
 // Return the system's kernel identifier (string)
-std::string System::Kernel() { return LinuxParser::Kernel(); }
+std::string System::Kernel() { return kernel; }
 
 // Return the system's memory utilization
-float System::MemoryUtilization() { return LinuxParser::MemoryUtilization(); }
+float System::MemoryUtilization() { return current.memory_utilization; }
 
 // Return the operating system name
-std::string System::OperatingSystem() { return LinuxParser::OperatingSystem(); }
+std::string System::OperatingSystem() { return operating_system; }
 
 // Return the number of processes actively running on the system
-int System::RunningProcesses() { return LinuxParser::RunningProcesses(); }
+int System::RunningProcesses() { return current.running_processes; }
 
 // Return the total number of processes on the system
-int System::TotalProcesses() { return LinuxParser::TotalProcesses(); }
+int System::TotalProcesses() { return current.total_processes; }
 
 // Return the number of seconds since the system started running
-long int System::UpTime() { return LinuxParser::UpTime(); }
+long int System::UpTime() { return current.uptime; }
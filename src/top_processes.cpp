@@ -0,0 +1,56 @@
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+#include "instrumentation.h"
+#include "top_processes.h"
+
+using std::size_t;
+using std::vector;
+
+namespace {
+// Larger values sort first
+double SortValue(const ProcessSnapshot& snapshot, SortKey key) {
+  switch (key) {
+    case SortKey::kCpu:
+      return snapshot.cpu_utilization;
+    case SortKey::kRss:
+      return snapshot.rss;
+    case SortKey::kVsz:
+      return snapshot.vsz;
+    case SortKey::kTime:
+      return snapshot.uptime;
+    case SortKey::kPid:
+      return -snapshot.pid;
+  }
+  return 0;
+}
+}  // namespace
+
+// Return views of the n first processes; they stay valid as long as the
+// snapshot is not modified
+vector<Process>& TopProcesses::Select(const SystemSnapshot& snapshot,
+                                      size_t n) {
+  Instrumentation::ScopedTimer timer(Instrumentation::Phase::kSort);
+  const vector<ProcessSnapshot>& all = snapshot.processes;
+  ranked.resize(all.size());
+  for (size_t i = 0; i < all.size(); ++i) {
+    ranked[i] = {SortValue(all[i], sort_key), all[i].pid, i};
+  }
+
+  n = std::min(n, all.size());
+  if (n < all.size()) {
+    std::nth_element(ranked.begin(), ranked.begin() + n, ranked.end());
+  }
+  std::sort(ranked.begin(), ranked.begin() + n);
+
+  processes.clear();
+  for (size_t i = 0; i < n; ++i) {
+    processes.emplace_back(all[ranked[i].index]);
+  }
+  return processes;
+}
+
+void TopProcesses::SortBy(SortKey key) { sort_key = key; }
+
+SortKey TopProcesses::Sorting() const { return sort_key; }
@@ -0,0 +1,116 @@
+#include <pwd.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <charconv>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "linux_parser.h"
+#include "user_cache.h"
+
+#define PASSWD_BUFFER 4096
+
+using std::string;
+using std::string_view;
+
+UserCache& UserCache::Instance() {
+  static UserCache cache;
+  return cache;
+}
+
+bool UserCache::Changed(const struct stat& info) const {
+  return !loaded || info.st_dev != device || info.st_ino != inode ||
+         info.st_size != size || info.st_mtim.tv_sec != modified.tv_sec ||
+         info.st_mtim.tv_nsec != modified.tv_nsec;
+}
+
+void UserCache::Refresh() {
+  struct stat info {};
+  if (stat(LinuxParser::PasswordPath().c_str(), &info) != 0) {
+    if (!loaded) Load();
+    return;
+  }
+  if (Changed(info)) {
+    Load();
+    device = info.st_dev;
+    inode = info.st_ino;
+    size = info.st_size;
+    modified = info.st_mtim;
+  }
+}
+
+// Parse name:passwd:uid:... lines of the whole file in one pass
+void UserCache::Load() {
+  names.clear();
+  uids.clear();
+  loaded = true;
+
+  std::ifstream stream(LinuxParser::PasswordPath(), std::ios::binary);
+  if (!stream.is_open()) return;
+  const string content{std::istreambuf_iterator<char>(stream),
+                       std::istreambuf_iterator<char>()};
+
+  string_view rest(content);
+  while (!rest.empty()) {
+    size_t end = rest.find('\n');
+    string_view line = rest.substr(0, end);
+    rest = end == string_view::npos ? string_view() : rest.substr(end + 1);
+
+    size_t name_end = line.find(':');
+    if (name_end == string_view::npos) continue;
+    size_t passwd_end = line.find(':', name_end + 1);
+    if (passwd_end == string_view::npos) continue;
+    const char* first = line.data() + passwd_end + 1;
+    const char* last = line.data() + line.size();
+
+    int uid = 0;
+    if (std::from_chars(first, last, uid).ec != std::errc()) continue;
+    // The first entry wins, like getpwuid does for duplicated uids
+    names.emplace(uid, string(line.substr(0, name_end)));
+    uids.emplace(string(line.substr(0, name_end)), uid);
+  }
+}
+
+int UserCache::Uid(const string& name) {
+  if (!loaded) Refresh();
+
+  auto found = uids.find(name);
+  if (found != uids.end()) return found->second;
+
+  // Not in the file: ask NSS once and remember the answer, even a miss
+  struct passwd entry {};
+  struct passwd* result = nullptr;
+  std::vector<char> buffer(PASSWD_BUFFER);
+  int uid = -1;
+  if (getpwnam_r(name.c_str(), &entry, buffer.data(), buffer.size(),
+                 &result) == 0 &&
+      result != nullptr) {
+    uid = static_cast<int>(result->pw_uid);
+  }
+  uids.emplace(name, uid);
+  return uid;
+}
+
+const string& UserCache::Name(int uid) {
+  if (!loaded) Refresh();
+
+  auto found = names.find(uid);
+  if (found != names.end()) return found->second;
+
+  // Not in the file: ask NSS once and remember the answer, even a miss
+  struct passwd entry {};
+  struct passwd* result = nullptr;
+  std::vector<char> buffer(PASSWD_BUFFER);
+  string name;
+  if (getpwuid_r(static_cast<uid_t>(uid), &entry, buffer.data(),
+                 buffer.size(), &result) == 0 &&
+      result != nullptr) {
+    name = result->pw_name;
+  } else {
+    name = std::to_string(uid);
+  }
+  return names.emplace(uid, std::move(name)).first->second;
+}
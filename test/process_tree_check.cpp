@@ -0,0 +1,112 @@
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <vector>
+
+#include "process_snapshot.h"
+#include "process_tree.h"
+
+/*
+ProcessTree::Update against a tree built from scratch
+A sequence of snapshots has processes appear, exit, get adopted, come
+back after a filter left them out, and PIDs recycled. After each one the
+incrementally kept tree must give every process the same parent, depth
+and subtree totals as a new ProcessTree given only that snapshot.
+*/
+
+namespace {
+struct Placement {
+  int parent;
+  int depth;
+  double cpu;
+  int64_t rss;
+};
+
+// Parent, depth and totals of every process, from the rows
+std::map<int, Placement> Placements(ProcessTree& tree) {
+  std::map<int, Placement> placements;
+  std::vector<int> path;
+  for (const ProcessTree::Row& row : tree.Rows()) {
+    path.resize(row.depth);
+    placements[row.process->pid] = {path.empty() ? 0 : path.back(), row.depth,
+                                    row.cpu, row.rss};
+    path.push_back(row.process->pid);
+  }
+  return placements;
+}
+
+ProcessSnapshot Process(int pid, int ppid, long starttime = 0) {
+  ProcessSnapshot process;
+  process.pid = pid;
+  process.ppid = ppid;
+  process.starttime = starttime ? starttime : pid;
+  process.cpu_utilization = 0.01f * pid;
+  process.rss = 100 * pid;
+  return process;
+}
+
+// Tick i, in PID order like a snapshot
+std::vector<ProcessSnapshot> Snapshot(int i) {
+  std::vector<ProcessSnapshot> processes{Process(1, 0), Process(2, 0)};
+  // 10 is left out by a filter on ticks 2 and 3; 11 and 12 keep ppid 10
+  if (i < 2 || i > 3) processes.push_back(Process(10, 1));
+  processes.push_back(Process(11, 10));
+  processes.push_back(Process(12, 10));
+  // 20 exits on tick 2 and 21 is adopted by 1 a tick later
+  if (i < 2) processes.push_back(Process(20, 1));
+  if (i >= 1) processes.push_back(Process(21, i < 3 ? 20 : 1));
+  // A parent with a larger PID than its child, absent on tick 4
+  processes.push_back(Process(30, 50));
+  if (i != 4) processes.push_back(Process(50, 2));
+  // PID 40 is recycled on tick 3, under another parent
+  processes.push_back(i < 3 ? Process(40, 12) : Process(40, 2, 1000));
+  if (i == 5) processes.push_back(Process(60, 30));
+  std::sort(processes.begin(), processes.end(),
+            [](const ProcessSnapshot& a, const ProcessSnapshot& b) {
+              return a.pid < b.pid;
+            });
+  return processes;
+}
+}  // namespace
+
+int main() {
+  int failures = 0;
+  ProcessTree kept;
+  std::vector<std::vector<ProcessSnapshot>> ticks;
+  for (int i = 0; i < 7; ++i) ticks.push_back(Snapshot(i));
+  for (int i = 0; i < 7; ++i) {
+    const std::vector<ProcessSnapshot>& processes = ticks[i];
+    kept.Update(processes);
+    ProcessTree fresh;
+    fresh.Update(processes);
+    const std::map<int, Placement> expected = Placements(fresh);
+    const std::map<int, Placement> actual = Placements(kept);
+    if (expected.size() != actual.size()) {
+      std::fprintf(stderr, "tick %d: %zu rows instead of %zu\n", i,
+                   actual.size(), expected.size());
+      ++failures;
+      continue;
+    }
+    for (const auto& [pid, want] : expected) {
+      const auto found = actual.find(pid);
+      if (found == actual.end()) {
+        std::fprintf(stderr, "tick %d: pid %d missing\n", i, pid);
+        ++failures;
+        continue;
+      }
+      const Placement& got = found->second;
+      if (got.parent != want.parent || got.depth != want.depth ||
+          std::fabs(got.cpu - want.cpu) > 1e-6 || got.rss != want.rss) {
+        std::fprintf(stderr,
+                     "tick %d: pid %d under %d at depth %d, expected under "
+                     "%d at depth %d\n",
+                     i, pid, got.parent, got.depth, want.parent, want.depth);
+        ++failures;
+      }
+    }
+  }
+  return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,221 @@
+#include <unistd.h>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "snapshot_codec.h"
+#include "system_snapshot.h"
+
+/*
+Round trip of SnapshotEncoder and SnapshotDecoder
+A few ticks with processes and cgroups coming, changing and going are
+encoded, as deltas and as keyframes, and every decoded field must equal
+the original. Fields() counts the members of each struct, so adding one
+fails to compile here until it is compared below and the codec carries
+it.
+*/
+
+namespace {
+// Converts to any member type, to count members by brace initialization
+struct Any {
+  template <typename T>
+  operator T() const;
+};
+
+template <typename T, typename Indices, typename = void>
+struct Braces : std::false_type {};
+template <typename T, std::size_t... I>
+struct Braces<T, std::index_sequence<I...>,
+              std::void_t<decltype(T{(I, Any{})...})>> : std::true_type {};
+
+template <typename T, std::size_t N = 0>
+constexpr std::size_t Fields() {
+  if constexpr (Braces<T, std::make_index_sequence<N + 1>>::value) {
+    return Fields<T, N + 1>();
+  } else {
+    return N;
+  }
+}
+
+static_assert(Fields<ProcessSnapshot>() == 17,
+              "compare the new ProcessSnapshot field in Same and encode it");
+static_assert(Fields<CgroupSnapshot>() == 9,
+              "compare the new CgroupSnapshot field in Same and encode it");
+static_assert(Fields<MemorySnapshot>() == 10,
+              "compare the new MemorySnapshot field in Same and encode it");
+static_assert(Fields<SystemSnapshot>() == 16,
+              "compare the new SystemSnapshot field in Same and encode it");
+
+int failures = 0;
+
+template <typename T>
+void Expect(const char* field, std::size_t tick, const T& expected,
+            const T& actual) {
+  if (expected == actual) return;
+  std::fprintf(stderr, "tick %zu: %s differs after decoding\n", tick, field);
+  ++failures;
+}
+
+#define EXPECT_SAME(field) Expect(#field, tick, expected.field, actual.field)
+
+void Same(std::size_t tick, const ProcessSnapshot& expected,
+          const ProcessSnapshot& actual) {
+  EXPECT_SAME(pid);
+  EXPECT_SAME(ppid);
+  EXPECT_SAME(uid);
+  EXPECT_SAME(user);
+  EXPECT_SAME(command);
+  EXPECT_SAME(name);
+  EXPECT_SAME(state);
+  EXPECT_SAME(vsz);
+  EXPECT_SAME(rss);
+  EXPECT_SAME(shared);
+  EXPECT_SAME(pss);
+  EXPECT_SAME(uss);
+  EXPECT_SAME(utime);
+  EXPECT_SAME(stime);
+  EXPECT_SAME(starttime);
+  EXPECT_SAME(uptime);
+  EXPECT_SAME(cpu_utilization);
+}
+
+void Same(std::size_t tick, const CgroupSnapshot& expected,
+          const CgroupSnapshot& actual) {
+  EXPECT_SAME(path);
+  EXPECT_SAME(processes);
+  EXPECT_SAME(cpu);
+  EXPECT_SAME(throttled);
+  EXPECT_SAME(memory);
+  EXPECT_SAME(anon);
+  EXPECT_SAME(file);
+  EXPECT_SAME(read_rate);
+  EXPECT_SAME(write_rate);
+}
+
+// tick and timestamp_ms travel in the record and slot headers, readers
+// rebuild table, strings only backs the views and refresh_period only
+// concerns the live sampler
+void Same(std::size_t tick, const SystemSnapshot& expected,
+          const SystemSnapshot& actual) {
+  EXPECT_SAME(operating_system);
+  EXPECT_SAME(kernel);
+  EXPECT_SAME(cpu_utilization);
+  EXPECT_SAME(core_utilization);
+  EXPECT_SAME(memory_utilization);
+  EXPECT_SAME(memory.total);
+  EXPECT_SAME(memory.available);
+  EXPECT_SAME(memory.free);
+  EXPECT_SAME(memory.buffers);
+  EXPECT_SAME(memory.cached);
+  EXPECT_SAME(memory.shared);
+  EXPECT_SAME(memory.swap_total);
+  EXPECT_SAME(memory.swap_free);
+  EXPECT_SAME(memory.huge_total);
+  EXPECT_SAME(memory.huge_free);
+  EXPECT_SAME(uptime);
+  EXPECT_SAME(total_processes);
+  EXPECT_SAME(running_processes);
+  EXPECT_SAME(processes.size());
+  EXPECT_SAME(cgroups.size());
+  if (failures) return;
+  for (std::size_t i = 0; i < expected.processes.size(); ++i) {
+    Same(tick, expected.processes[i], actual.processes[i]);
+  }
+  for (std::size_t i = 0; i < expected.cgroups.size(); ++i) {
+    Same(tick, expected.cgroups[i], actual.cgroups[i]);
+  }
+}
+
+ProcessSnapshot Process(SystemSnapshot& snapshot, int pid, const char* name,
+                        long size) {
+  ProcessSnapshot process;
+  process.pid = pid;
+  process.ppid = pid / 2;
+  process.uid = pid * 10;
+  process.user = snapshot.strings.Copy(pid % 2 ? "root" : "www");
+  process.command = snapshot.strings.Copy(pid % 3 ? "/usr/bin/worker -q" : "");
+  process.name = name;
+  process.state = 'S';
+  process.vsz = size * 4;
+  process.rss = size;
+  process.shared = size / 2;
+  process.pss = pid % 2 ? size / 3 : -1;
+  process.uss = pid % 2 ? size / 4 : -1;
+  process.utime = size * 7;
+  process.stime = size * 3;
+  process.starttime = pid * 100;
+  process.cpu_utilization = 0.125f * pid;
+  return process;
+}
+
+CgroupSnapshot Cgroup(const char* path, int processes, double rate) {
+  CgroupSnapshot cgroup;
+  cgroup.path = path;
+  cgroup.processes = processes;
+  cgroup.cpu = 0.75f * processes;
+  cgroup.throttled = 0.01f * processes;
+  cgroup.memory = 4096 * processes;
+  cgroup.anon = 1024 * processes;
+  cgroup.file = 2048 * processes;
+  cgroup.read_rate = rate;
+  cgroup.write_rate = rate / 3;
+  return cgroup;
+}
+
+// Tick i of a made up system; processes come and go and change
+void Fill(SystemSnapshot& snapshot, std::size_t i) {
+  const long hertz = sysconf(_SC_CLK_TCK);
+  snapshot.strings.Reset();
+  snapshot.operating_system = "Test Linux";
+  snapshot.kernel = "6.1.0";
+  snapshot.cpu_utilization = 0.1f * i;
+  snapshot.core_utilization = {0.25f, 0.5f * (i % 2), 0.125f};
+  snapshot.memory_utilization = 0.3f + 0.01f * i;
+  snapshot.memory = {16000000, 9000000 - long(i) * 1000, 4000000, 200000,
+                     3000000 + long(i), 50000, 2000000, 1999000,
+                     i % 2 ? 0 : 2048, 0};
+  snapshot.uptime = 5000 + i;
+  snapshot.total_processes = 100 + i * 3;
+  snapshot.running_processes = 1 + i % 3;
+
+  snapshot.processes.clear();
+  snapshot.processes.push_back(Process(snapshot, 1, "init", 1000));
+  if (i != 2) snapshot.processes.push_back(Process(snapshot, 2, "kthreadd", 0));
+  snapshot.processes.push_back(Process(snapshot, 7, i < 3 ? "sh" : "bash",
+                                       5000 + long(i) * 10));
+  if (i >= 1) snapshot.processes.push_back(Process(snapshot, 300, "cc1", 9000));
+  if (i == 3) snapshot.processes.back().state = 'R';
+  for (ProcessSnapshot& process : snapshot.processes) {
+    process.uptime = snapshot.uptime - process.starttime / hertz;
+  }
+
+  snapshot.cgroups.clear();
+  snapshot.cgroups.push_back(Cgroup("/", 1, 0));
+  if (i != 1) snapshot.cgroups.push_back(Cgroup("/system.slice", 2, 1e6 * i));
+  snapshot.cgroups.push_back(
+      Cgroup(i < 2 ? "/user.slice" : "/user.slice/user-1000.slice", 3, 12.5));
+}
+}  // namespace
+
+int main() {
+  SnapshotEncoder encoder;
+  SnapshotDecoder decoder;
+  SystemSnapshot original;
+  SystemSnapshot decoded;
+  std::vector<uint8_t> record;
+  for (std::size_t tick = 0; tick < 6; ++tick) {
+    Fill(original, tick);
+    const bool keyframe = tick == 0 || tick == 4;
+    record.clear();
+    encoder.Encode(original, keyframe, record);
+    if (!decoder.Decode(record.data(), record.size(), keyframe, decoded)) {
+      std::fprintf(stderr, "tick %zu: record rejected\n", tick);
+      return 1;
+    }
+    Same(tick, original, decoded);
+  }
+  return failures == 0 ? 0 : 1;
+}